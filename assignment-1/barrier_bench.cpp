@@ -0,0 +1,136 @@
+#include <iostream>
+#include <unistd.h>
+#include <vector>
+#include <string>
+#include <thread>
+#include <barrier.hpp>
+#include <affinity.hpp>
+#include <fstream>
+
+#define DEFAULT_LOG_FILE "barrier_bench_log.csv" // default log file name
+#define DEFAULT_T 2 // default maximum number of threads
+#define DEFAULT_r 10000 // default number of barriers per measure
+#define DEFAULT_AFFINITY "none" // default placement of the threads
+
+#define TIMERSTART(label)\
+	std::chrono::time_point<std::chrono::system_clock> a##label, b##label;\
+	a##label = std::chrono::system_clock::now();
+
+#define TIMERSTOP(label, time_elapsed)\
+	b##label = std::chrono::system_clock::now();\
+	std::chrono::duration<double> delta##label = b##label-a##label;\
+	time_elapsed = delta##label.count();
+
+// T threads pass r times through the barrier, returns the time elapsed on
+// the first thread from the warm-up barrier (all the threads started and
+// pinned) to the last one (all the threads arrived)
+template <typename Barrier>
+double bench_barrier(
+	Barrier &bar,
+	const uint32_t T,
+	const uint64_t r,
+	const std::vector<int> &cpus
+	) {
+
+	double time = 0;
+	auto episodes = [&] (const uint32_t id) -> void {
+		pin_thread(cpus, id);
+		bar.arrive_and_wait(id); // warm-up, all the threads are started
+		double elapsed;
+		TIMERSTART(barrier);
+		for (uint64_t i=0; i<r; ++i)
+			bar.arrive_and_wait(id);
+		TIMERSTOP(barrier, elapsed);
+		if (id == 0)
+			time = elapsed;
+	};
+
+	std::vector<std::thread> threads;
+	for (uint32_t id=1; id<T; ++id)
+		threads.emplace_back(episodes, id);
+	episodes(0);
+	for (auto &thread : threads)
+		thread.join();
+	return time;
+}
+
+void print_usage() {
+	std::printf("usage: barrier_bench [options]\n"
+				"     -h               prints this message\n"
+				"     -T num_threads   maximum number of threads, the barriers\n"
+				"                      are measured with 1, 2, 4, ... and T\n"
+				"                      threads [default=%d]\n"
+				"     -r rounds        barriers per measure [default=%d]\n"
+				"     -a affinity      placement of the threads: none, compact,\n"
+				"                      scatter or a list of cpus as 0,2,4-7\n"
+				"                      [default=%s]\n"
+				"     -l file_name     log file name [default=%s]\n",
+				DEFAULT_T, DEFAULT_r, DEFAULT_AFFINITY, DEFAULT_LOG_FILE);
+}
+
+int main(int argc, char *argv[]) {
+	uint32_t T                = DEFAULT_T;
+	uint64_t r                = DEFAULT_r;
+	std::string affinity      = DEFAULT_AFFINITY;
+	std::string log_file_name = DEFAULT_LOG_FILE;
+
+	int opt;
+	while ((opt = getopt(argc, argv, "hT:r:a:l:")) != -1) {
+		switch (opt) {
+			case 'h':
+				print_usage();
+				return 0;
+			case 'T':
+				T = std::max(atoi(optarg), 1);
+				break;
+			case 'r':
+				r = std::max(atoi(optarg), 1);
+				break;
+			case 'a':
+				affinity = optarg;
+				break;
+			case 'l':
+				log_file_name = optarg;
+				break;
+			default:
+				print_usage();
+				return 1;
+		}
+	}
+
+	std::vector<int> cpus;
+	try {
+		cpus = thread_cpus(affinity, T);
+	}
+	catch (const std::exception &e) {
+		std::cerr << e.what() << ".\n";
+		print_usage();
+		return 1;
+	}
+
+	std::vector<uint32_t> threads;
+	for (uint32_t t=1; t<T; t*=2)
+		threads.push_back(t);
+	threads.push_back(T);
+
+	// write the latencies to a file
+	// (barrier, T, affinity, rounds, time, ns per barrier)
+	std::ofstream file;
+	file.open(log_file_name, std::ios_base::app);
+	for (const uint32_t t : threads) {
+		for (const char *kind : {"std", "central", "tree", "dissemination"}) {
+			double time;
+			with_barrier(kind, t, cpus, [&](auto &bar) {
+				time = bench_barrier(bar, t, r, cpus);
+			});
+			double latency = time/r*1e9;
+			file << kind << "," << t << ","
+				<< (affinity.find_first_of("0123456789") == 0 ? "list" : affinity)
+				<< "," << r << "," << time << "," << latency << "\n";
+			std::printf("%-13s T=%u: %.1f ns per barrier\n", kind, t, latency);
+		}
+	}
+	file.close();
+
+	return 0;
+}
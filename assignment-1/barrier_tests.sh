@@ -0,0 +1,33 @@
+#!/bin/bash
+
+REPETITIONS=5
+ROUNDS=100000
+NUM_CORES=40
+LOGFILE="barrier_bench_log.csv"
+
+# parsing command line arguments
+# (both optional, first one is the number of cores, second one is the log file)
+if [ $# -gt 0 ]; then
+    NUM_CORES=$1
+    if ! [[ $NUM_CORES =~ ^[0-9]+$ ]] ||
+        [ $NUM_CORES -lt 1 ] ||
+        [ $NUM_CORES -gt 60 ]; then
+        echo "Please provide a number in [1, 60] for the first argument."
+        exit 1
+    fi
+    if [ $# -gt 1 ]; then
+        LOGFILE=$2
+    fi
+fi
+
+# empty the log file
+truncate -s 0 $LOGFILE
+
+######################## COMPARING THE BARRIERS ################################
+echo "Comparing the latency of the barriers"
+for affinity in none compact scatter; do
+    for rep in $(seq 1 $REPETITIONS); do
+        echo "[$rep/$REPETITIONS] T = $NUM_CORES, rounds = $ROUNDS, affinity = $affinity"
+        ./barrier_bench -T $NUM_CORES -r $ROUNDS -a $affinity -l $LOGFILE
+    done
+done
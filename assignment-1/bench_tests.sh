@@ -0,0 +1,42 @@
+#!/bin/bash
+
+THREADS_STEP=4
+WARMUP=1
+REPETITIONS=10
+DEFAULT_N=512
+DEFAULT_MIN=0
+DEFAULT_MAX=1000
+NUM_CORES=40
+LOGFILE="wavefront_bench_log.csv"
+
+# parsing command line arguments
+# (both optional, first one is the number of cores, second one is the log file)
+if [ $# -gt 0 ]; then
+    NUM_CORES=$1
+    if ! [[ $NUM_CORES =~ ^[0-9]+$ ]] ||
+        [ $NUM_CORES -lt 1 ] ||
+        [ $NUM_CORES -gt 60 ]; then
+        echo "Please provide a number in [1, 60] for the first argument."
+        exit 1
+    fi
+    if [ $# -gt 1 ]; then
+        LOGFILE=$2
+    fi
+fi
+
+# empty the log file
+truncate -s 0 $LOGFILE
+
+# 1, THREADS_STEP, 2*THREADS_STEP, ..., NUM_CORES
+THREADS=1
+for t in $(seq $THREADS_STEP $THREADS_STEP $NUM_CORES); do
+    THREADS="$THREADS,$t"
+done
+
+######################## TESTING STRONG SCALABILITY ############################
+# all the thread counts and algorithms in a single process, the sequential
+# algorithm is timed once as the reference of the speedup
+echo "Testing strong scalability (T = $THREADS)"
+./wavefront -N $DEFAULT_N -m $DEFAULT_MIN -M $DEFAULT_MAX -L $THREADS \
+    -A sequential,dynamic,static,balanced,guided,doacross,dataflow,priority,coroutine,tiled \
+    -u $WARMUP -R $REPETITIONS -l $LOGFILE
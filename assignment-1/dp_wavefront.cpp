@@ -0,0 +1,204 @@
+#include <iostream>
+#include <unistd.h>
+#include <vector>
+#include <string>
+#include <random>
+#include <threadPool.hpp>
+#include <barrier.hpp>
+#include <wavefront.hpp>
+#include <fstream>
+#include <algorithm>
+
+#define DEFAULT_LOG_FILE "dp_wavefront_log.csv" // default log file name
+#define DEFAULT_n 4096 // default length of the first sequence
+#define DEFAULT_m 4096 // default length of the second sequence
+#define DEFAULT_T 2 // default number of threads
+#define DEFAULT_KERNEL "edit" // default dynamic programming problem
+#define MATCH 3 // Smith-Waterman score of a match
+#define MISMATCH -3 // Smith-Waterman score of a mismatch
+#define GAP -2 // Smith-Waterman score of a gap
+
+#define TIMERSTART(label)\
+	std::chrono::time_point<std::chrono::system_clock> a##label, b##label;\
+	a##label = std::chrono::system_clock::now();
+
+#define TIMERSTOP(label, time_elapsed)\
+	b##label = std::chrono::system_clock::now();\
+	std::chrono::duration<double> delta##label = b##label-a##label;\
+	time_elapsed = delta##label.count();
+
+// random sequence of n bases
+std::string random_sequence(const uint64_t n, std::mt19937 &generator) {
+	std::uniform_int_distribution<int> distribution(0, 3);
+	std::string sequence(n, 'A');
+	for (auto &base : sequence)
+		base = "ACGT"[distribution(generator)];
+	return sequence;
+}
+
+// (n+1)x(m+1) table of the dynamic programming on the sequences a and b,
+// the element (i,j) refers to the prefixes of length i and j; the first
+// row and column are given, the rest is computed by the wavefront
+struct Table {
+	uint64_t cols;
+	std::vector<int> cells;
+
+	Table(uint64_t n, uint64_t m) :
+		cols(m+1),
+		cells((n+1)*(m+1), 0) {}
+
+	int& operator()(const uint64_t &i, const uint64_t &j) {
+		return cells[i*cols+j];
+	}
+};
+
+// edit distance (Levenshtein): the first row and column are the distances
+// from the empty prefix
+struct EditDistance {
+	const std::string &a, &b;
+	Table &D;
+
+	EditDistance(const std::string &a_, const std::string &b_, Table &D_) :
+		a(a_), b(b_), D(D_) {
+		for (uint64_t i=0; i<=a.size(); ++i) D(i,0) = i;
+		for (uint64_t j=0; j<=b.size(); ++j) D(0,j) = j;
+	}
+
+	// the element (row,col) of the wavefront is (row+1,col+1) in the table
+	void operator()(const uint64_t &row, const uint64_t &col) {
+		const uint64_t i = row+1, j = col+1;
+		D(i,j) = std::min({D(i-1,j)+1, D(i,j-1)+1,
+			D(i-1,j-1) + (a[i-1] != b[j-1])});
+	}
+};
+
+// Smith-Waterman local alignment score with a linear gap penalty: the
+// first row and column are zero
+struct SmithWaterman {
+	const std::string &a, &b;
+	Table &H;
+
+	SmithWaterman(const std::string &a_, const std::string &b_, Table &H_) :
+		a(a_), b(b_), H(H_) {}
+
+	void operator()(const uint64_t &row, const uint64_t &col) {
+		const uint64_t i = row+1, j = col+1;
+		H(i,j) = std::max({0, H(i-1,j)+GAP, H(i,j-1)+GAP,
+			H(i-1,j-1) + ((a[i-1] == b[j-1]) ? MATCH : MISMATCH)});
+	}
+};
+
+// computes the table of the kernel for a and b with the scheduler
+template <typename Kernel, typename Scheduler>
+Table solve(const std::string &a, const std::string &b, Scheduler &&scheduler,
+	double &time) {
+	Table table(a.size(), b.size());
+	Kernel kernel(a, b, table);
+	TIMERSTART(solve);
+	wavefront(kernel, scheduler, AntiDiagonals(a.size(), b.size()));
+	TIMERSTOP(solve, time);
+	return table;
+}
+
+// solves the problem with the sequential, static and dynamic schedulers,
+// checks that the parallel tables are equal to the sequential one and
+// returns the result (last element for the edit distance, maximum for
+// Smith-Waterman)
+template <typename Kernel>
+int run(const std::string &a, const std::string &b, const uint32_t T,
+	std::vector<double> &times, bool &ok) {
+
+	times.assign(3, 0);
+	Table expected = solve<Kernel>(a, b, SequentialScheduler(), times[0]);
+
+	CentralBarrier bar(T);
+	Table D_static = solve<Kernel>(a, b, StaticScheduler(bar, T), times[1]);
+
+	ThreadPool TP(T);
+	Table D_dynamic = solve<Kernel>(a, b, DynamicScheduler(TP), times[2]);
+
+	ok = (D_static.cells == expected.cells) &&
+		(D_dynamic.cells == expected.cells);
+	return std::is_same_v<Kernel, EditDistance> ? expected.cells.back() :
+		*std::max_element(expected.cells.begin(), expected.cells.end());
+}
+
+void print_usage() {
+	std::printf("usage: dp_wavefront [options]\n"
+				"     -h               prints this message\n"
+				"     -n length        length of the first sequence [default=%d]\n"
+				"     -m length        length of the second sequence [default=%d]\n"
+				"     -T num_threads   number of threads [default=%d]\n"
+				"     -k kernel        edit (edit distance) or sw (Smith-Waterman\n"
+				"                      local alignment score) [default=%s]\n"
+				"     -l file_name     log file name [default=%s]\n",
+				DEFAULT_n, DEFAULT_m, DEFAULT_T, DEFAULT_KERNEL, DEFAULT_LOG_FILE);
+}
+
+int main(int argc, char *argv[]) {
+	uint64_t n                = DEFAULT_n;
+	uint64_t m                = DEFAULT_m;
+	uint32_t T                = DEFAULT_T;
+	std::string kernel        = DEFAULT_KERNEL;
+	std::string log_file_name = DEFAULT_LOG_FILE;
+
+	int opt;
+	while ((opt = getopt(argc, argv, "hn:m:T:k:l:")) != -1) {
+		switch (opt) {
+			case 'h':
+				print_usage();
+				return 0;
+			case 'n':
+				n = std::max(atoi(optarg), 1);
+				break;
+			case 'm':
+				m = std::max(atoi(optarg), 1);
+				break;
+			case 'T':
+				T = std::max(atoi(optarg), 1);
+				break;
+			case 'k':
+				kernel = optarg;
+				break;
+			case 'l':
+				log_file_name = optarg;
+				break;
+			default:
+				print_usage();
+				return 1;
+		}
+	}
+
+	std::mt19937 generator(117);
+	std::string a = random_sequence(n, generator);
+	std::string b = random_sequence(m, generator);
+
+	std::vector<double> times;
+	bool ok;
+	int result;
+	if (kernel == "edit")
+		result = run<EditDistance>(a, b, T, times, ok);
+	else if (kernel == "sw")
+		result = run<SmithWaterman>(a, b, T, times, ok);
+	else {
+		std::cerr << "Unknown kernel `" << kernel << "`.\n";
+		print_usage();
+		return 1;
+	}
+
+	std::printf("%s n=%lu m=%lu T=%u: result %d, sequential %fs, static %fs, "
+		"dynamic %fs\n", kernel.c_str(), n, m, T, result, times[0], times[1],
+		times[2]);
+	if (!ok)
+		std::cerr << "The parallel results differ from the sequential one.\n";
+
+	// write the execution times to a file
+	// (kernel, n, m, T, result, sequential, static, dynamic, check)
+	std::ofstream file;
+	file.open(log_file_name, std::ios_base::app);
+	file << kernel << "," << n << "," << m << "," << T << "," << result << ","
+		<< times[0] << "," << times[1] << "," << times[2] << "," << ok << "\n";
+	file.close();
+
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,175 @@
+#ifndef AFFINITY_HPP
+#define AFFINITY_HPP
+
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <utility>
+#include <string>
+#include <sstream>
+#include <vector>
+#include <fstream>
+#include <algorithm>
+#include <stdexcept>
+#include <pthread.h>
+#include <sched.h>
+
+// a logical cpu the process is allowed to run on
+struct Cpu {
+	int id;
+	int package; // socket
+	int core;    // physical core in the socket
+	int sibling; // rank among the hyperthreads of the same core
+};
+
+inline int read_topology(int cpu, const std::string &name, int fallback) {
+	std::ifstream file("/sys/devices/system/cpu/cpu" + std::to_string(cpu) +
+		"/topology/" + name);
+	int value;
+	if (file >> value)
+		return value;
+	return fallback;
+}
+
+// the cpus in the affinity mask of the process, sorted by id
+inline std::vector<Cpu> available_cpus() {
+	std::vector<Cpu> cpus;
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	if (sched_getaffinity(0, sizeof(set), &set) != 0)
+		return cpus;
+
+	for (int id=0; id<CPU_SETSIZE; ++id) {
+		if (!CPU_ISSET(id, &set))
+			continue;
+		Cpu cpu;
+		cpu.id = id;
+		cpu.package = read_topology(id, "physical_package_id", 0);
+		cpu.core = read_topology(id, "core_id", id);
+		cpu.sibling = 0;
+		for (const Cpu &other : cpus)
+			if (other.package == cpu.package && other.core == cpu.core)
+				cpu.sibling++;
+		cpus.push_back(cpu);
+	}
+	return cpus;
+}
+
+// compact: threads fill a socket (core by core, hyperthreads
+// included) before moving to the next one
+inline std::vector<int> compact_cpus(std::vector<Cpu> cpus) {
+	std::sort(cpus.begin(), cpus.end(), [](const Cpu &a, const Cpu &b) {
+		if (a.package != b.package) return a.package < b.package;
+		if (a.core != b.core) return a.core < b.core;
+		return a.id < b.id;
+	});
+	std::vector<int> ids;
+	for (const Cpu &cpu : cpus)
+		ids.push_back(cpu.id);
+	return ids;
+}
+
+// scatter: consecutive threads go to different sockets, and a socket
+// gets a thread on each physical core before using the hyperthreads
+inline std::vector<int> scatter_cpus(std::vector<Cpu> cpus) {
+	std::sort(cpus.begin(), cpus.end(), [](const Cpu &a, const Cpu &b) {
+		if (a.package != b.package) return a.package < b.package;
+		if (a.sibling != b.sibling) return a.sibling < b.sibling;
+		return a.core < b.core;
+	});
+	std::vector<std::vector<int>> packages;
+	for (uint64_t i=0; i<cpus.size(); ++i) {
+		if (i == 0 || cpus[i].package != cpus[i-1].package)
+			packages.emplace_back();
+		packages.back().push_back(cpus[i].id);
+	}
+	std::vector<int> ids;
+	for (uint64_t rank=0; ids.size()<cpus.size(); ++rank)
+		for (const auto &package : packages)
+			if (rank < package.size())
+				ids.push_back(package[rank]);
+	return ids;
+}
+
+// parses a list of cpus such as "0,2,4-7"
+inline std::vector<int> parse_cpu_list(const std::string &list) {
+	std::vector<int> ids;
+	std::stringstream stream(list);
+	std::string item;
+	while (std::getline(stream, item, ',')) {
+		int first, last;
+		char extra;
+		int matched = std::sscanf(item.c_str(), "%d-%d%c", &first, &last, &extra);
+		if (matched == 1 && std::sscanf(item.c_str(), "%d%c", &first, &extra) == 1)
+			last = first; // a single cpu
+		else if (matched != 2) // not a range either
+			throw std::invalid_argument("invalid cpu list `" + list + "`");
+		if (first < 0 || last < first)
+			throw std::invalid_argument("invalid cpu list `" + list + "`");
+		for (int id=first; id<=last; ++id)
+			ids.push_back(id);
+	}
+	return ids;
+}
+
+// the cpu of each one of T threads according to policy, which is either
+// "none" (no pinning, empty result), "compact", "scatter" or a cpu list;
+// if T exceeds the available cpus they are reused round-robin
+inline std::vector<int> thread_cpus(const std::string &policy, uint32_t T) {
+	std::vector<int> ids;
+	if (policy == "none")
+		return ids;
+	else if (policy == "compact")
+		ids = compact_cpus(available_cpus());
+	else if (policy == "scatter")
+		ids = scatter_cpus(available_cpus());
+	else
+		ids = parse_cpu_list(policy);
+
+	if (ids.empty())
+		return ids;
+	std::vector<int> cpus(T);
+	for (uint32_t t=0; t<T; ++t)
+		cpus[t] = ids[t % ids.size()];
+	return cpus;
+}
+
+// pins the calling thread to a cpu, returns false on failure
+inline bool pin_thread(int cpu) {
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(cpu, &set);
+	return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
+
+// pins the calling thread, the id-th of a group placed on cpus
+// (nothing to do if cpus is empty)
+inline void pin_thread(const std::vector<int> &cpus, uint64_t id) {
+	if (!cpus.empty())
+		pin_thread(cpus[id % cpus.size()]);
+}
+
+// allocator leaving the elements default-initialized, so that a vector of
+// int is not written on allocation and its pages can be first touched by
+// the threads that will use them
+template <typename Item>
+struct NoInitAllocator : std::allocator<Item> {
+	template <typename Other>
+	struct rebind { using other = NoInitAllocator<Other>; };
+
+	NoInitAllocator() = default;
+	template <typename Other>
+	NoInitAllocator(const NoInitAllocator<Other>&) {}
+
+	template <typename Element>
+	void construct(Element *p) {
+		::new (static_cast<void*>(p)) Element;
+	}
+
+	template <typename Element, typename ... Args>
+	void construct(Element *p, Args && ... args) {
+		::new (static_cast<void*>(p)) Element(std::forward<Args>(args)...);
+	}
+};
+
+#endif
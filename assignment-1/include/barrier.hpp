@@ -0,0 +1,289 @@
+#ifndef BARRIER_HPP
+#define BARRIER_HPP
+
+#include <cstdint>
+#include <atomic>
+#include <memory>
+#include <functional>
+#include <vector>
+#include <string>
+#include <barrier>
+#include <algorithm>
+#include <stdexcept>
+#include <spin.hpp>
+#include <affinity.hpp>
+
+// All the barriers synchronize a fixed group of T threads, the id-th of
+// which calls arrive_and_wait(id) (ids in [0, T)).
+
+// Sense-reversing centralized barrier: the last thread to arrive resets
+// the counter and flips the global sense the others are spinning on.
+class CentralBarrier {
+
+private:
+
+	const uint32_t T;
+	alignas(64) std::atomic<uint32_t> count;
+	alignas(64) std::atomic<bool> sense;
+	struct alignas(64) LocalSense {
+		bool value = false;
+	};
+	std::unique_ptr<LocalSense[]> local; // one per thread
+
+public:
+	explicit CentralBarrier(uint32_t T_) :
+		T(T_),
+		count(T_),
+		sense(false),
+		local(new LocalSense[T_]) {}
+
+	void arrive_and_wait(uint32_t id) {
+		bool my_sense = local[id].value = !local[id].value;
+		if (count.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+			count.store(T, std::memory_order_relaxed);
+			sense.store(my_sense, std::memory_order_release);
+		}
+		else {
+			spin_until([&] ( ) -> bool {
+				return sense.load(std::memory_order_acquire) == my_sense;
+			});
+		}
+	}
+};
+
+// Combining tree barrier: threads arrive on the counter of a leaf shared
+// with at most fan_in-1 others, the last one to arrive on a node goes on
+// to its parent and the last one on the root flips the global sense.
+// Leaves and inner nodes only group threads running on the same socket,
+// so that the cache lines of the counters move across sockets only at the
+// top of the tree (all threads on one socket if they are not pinned).
+class TreeBarrier {
+
+private:
+
+	struct alignas(64) Node {
+		std::atomic<uint32_t> count;
+		uint32_t fan_in;
+		Node *parent;
+	};
+
+	std::vector<std::unique_ptr<Node>> nodes;
+	std::vector<Node*> leaves; // of each thread
+	alignas(64) std::atomic<bool> sense;
+	struct alignas(64) LocalSense {
+		bool value = false;
+	};
+	std::unique_ptr<LocalSense[]> local; // one per thread
+
+	Node* make_node(uint32_t fan_in) {
+		nodes.emplace_back(std::make_unique<Node>());
+		nodes.back()->count = fan_in;
+		nodes.back()->fan_in = fan_in;
+		nodes.back()->parent = nullptr;
+		return nodes.back().get();
+	}
+
+	// groups children by fan_in under new parents, returns the parents
+	std::vector<Node*> combine(const std::vector<Node*> &children,
+		uint32_t fan_in) {
+		std::vector<Node*> parents;
+		for (uint64_t first=0; first<children.size(); first+=fan_in) {
+			uint64_t last = std::min<uint64_t>(first+fan_in, children.size());
+			Node *parent = make_node(last-first);
+			for (uint64_t c=first; c<last; ++c)
+				children[c]->parent = parent;
+			parents.push_back(parent);
+		}
+		return parents;
+	}
+
+public:
+	// cpus are the ones the threads are pinned to, as in pin_thread
+	TreeBarrier(uint32_t T, const std::vector<int> &cpus, uint32_t fan_in=4) :
+		leaves(T),
+		sense(false),
+		local(new LocalSense[T]) {
+
+		fan_in = std::max<uint32_t>(fan_in, 2);
+
+		// threads of each socket, in order of first appearance
+		std::vector<int> packages;
+		std::vector<std::vector<uint32_t>> members;
+		for (uint32_t id=0; id<T; ++id) {
+			int package = cpus.empty() ? 0 :
+				read_topology(cpus[id % cpus.size()], "physical_package_id", 0);
+			uint64_t p = std::find(packages.begin(), packages.end(), package)
+				- packages.begin();
+			if (p == packages.size()) {
+				packages.push_back(package);
+				members.emplace_back();
+			}
+			members[p].push_back(id);
+		}
+
+		// a subtree per socket, then a tree of the socket roots
+		std::vector<Node*> roots;
+		for (const auto &threads : members) {
+			std::vector<Node*> level;
+			for (uint64_t first=0; first<threads.size(); first+=fan_in) {
+				uint64_t last = std::min<uint64_t>(first+fan_in, threads.size());
+				Node *leaf = make_node(last-first);
+				for (uint64_t t=first; t<last; ++t)
+					leaves[threads[t]] = leaf;
+				level.push_back(leaf);
+			}
+			while (level.size() > 1)
+				level = combine(level, fan_in);
+			roots.push_back(level.front());
+		}
+		while (roots.size() > 1)
+			roots = combine(roots, fan_in);
+	}
+
+	void arrive_and_wait(uint32_t id) {
+		bool my_sense = local[id].value = !local[id].value;
+		Node *node = leaves[id];
+		while (node->count.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+			// last one on this node: nobody arrives here again
+			// before the release, reset it and go up
+			node->count.store(node->fan_in, std::memory_order_relaxed);
+			if (!node->parent) {
+				sense.store(my_sense, std::memory_order_release);
+				return;
+			}
+			node = node->parent;
+		}
+		spin_until([&] ( ) -> bool {
+			return sense.load(std::memory_order_acquire) == my_sense;
+		});
+	}
+};
+
+// Dissemination barrier (Hensgen, Finkel and Manber; as in Mellor-Crummey
+// and Scott): in the r-th of ceil(log2 T) rounds the thread id signals
+// the thread (id+2^r) mod T and waits for the signal of (id-2^r) mod T.
+// There is no shared counter, each flag is written by a single thread.
+class DisseminationBarrier {
+
+private:
+
+	static constexpr uint32_t max_rounds = 32;
+
+	struct alignas(64) Flag {
+		std::atomic<bool> value{false};
+	};
+
+	struct Local {
+		uint32_t parity = 0;
+		bool sense = true;
+	};
+
+	const uint32_t T;
+	uint32_t rounds;
+	std::unique_ptr<Flag[]> flags; // [thread][parity][round]
+	std::unique_ptr<Local[]> local; // one per thread
+
+	Flag& flag(uint32_t id, uint32_t parity, uint32_t round) {
+		return flags[(id*2+parity)*rounds+round];
+	}
+
+public:
+	explicit DisseminationBarrier(uint32_t T_) :
+		T(T_),
+		rounds(0),
+		local(new Local[T_]) {
+
+		while ((1ull << rounds) < T && rounds < max_rounds)
+			rounds++;
+		flags.reset(new Flag[T*2*std::max<uint32_t>(rounds, 1)]);
+	}
+
+	void arrive_and_wait(uint32_t id) {
+		Local &me = local[id];
+		for (uint32_t r=0; r<rounds; ++r) {
+			uint32_t partner = (id + (1u << r)) % T;
+			flag(partner, me.parity, r).value.store(me.sense,
+				std::memory_order_release);
+			Flag &mine = flag(id, me.parity, r);
+			spin_until([&] ( ) -> bool {
+				return mine.value.load(std::memory_order_acquire) == me.sense;
+			});
+		}
+		if (me.parity == 1)
+			me.sense = !me.sense;
+		me.parity = 1-me.parity;
+	}
+};
+
+// std::barrier with the interface of the others
+class StdBarrier {
+
+private:
+
+	std::barrier<> bar;
+
+public:
+	explicit StdBarrier(uint32_t T) : bar(T) {}
+
+	void arrive_and_wait(uint32_t) {
+		bar.arrive_and_wait();
+	}
+};
+
+// builds the barrier named kind (std, central, tree or dissemination) for
+// T threads pinned to cpus and calls func with it; the barrier type is
+// known at compile time inside func
+template <typename Func>
+void with_barrier(
+	const std::string &kind,
+	const uint32_t &T,
+	const std::vector<int> &cpus,
+	Func && func
+	) {
+
+	if (kind == "std") {
+		StdBarrier bar(T);
+		func(bar);
+	}
+	else if (kind == "central") {
+		CentralBarrier bar(T);
+		func(bar);
+	}
+	else if (kind == "tree") {
+		TreeBarrier bar(T, cpus);
+		func(bar);
+	}
+	else if (kind == "dissemination") {
+		DisseminationBarrier bar(T);
+		func(bar);
+	}
+	else
+		throw std::invalid_argument("unknown barrier `" + kind + "`");
+}
+
+// same, but the barrier is built once, owned by the returned function,
+// and func is called with it at each call: the construction (e.g. the
+// topology reads of the tree barrier) is left out of repeated calls
+template <typename Func>
+std::function<void()> bind_barrier(
+	const std::string &kind,
+	const uint32_t &T,
+	const std::vector<int> &cpus,
+	Func func
+	) {
+
+	auto bind = [&func] (auto bar) -> std::function<void()> {
+		return [bar, func] ( ) mutable -> void { func(*bar); };
+	};
+	if (kind == "std")
+		return bind(std::make_shared<StdBarrier>(T));
+	if (kind == "central")
+		return bind(std::make_shared<CentralBarrier>(T));
+	if (kind == "tree")
+		return bind(std::make_shared<TreeBarrier>(T, cpus));
+	if (kind == "dissemination")
+		return bind(std::make_shared<DisseminationBarrier>(T));
+	throw std::invalid_argument("unknown barrier `" + kind + "`");
+}
+
+#endif
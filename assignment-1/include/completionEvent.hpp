@@ -0,0 +1,168 @@
+#ifndef COMPLETIONEVENT_HPP
+#define COMPLETIONEVENT_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <array>
+#include <coroutine>
+#include <exception>
+#include <threadPool.hpp>
+
+// Coroutines on a ThreadPool. A Job is a coroutine that starts running as
+// soon as it is called and is destroyed when it returns, nobody waits for
+// it. It moves to the pool with co_await TP.schedule(), and waits for other
+// jobs through their completion events: co_await when_all(TP, events...)
+// suspends it until all the events are set and then resumes it on a thread
+// of the pool, with a single task however many events it waits for.
+
+// fire-and-forget coroutine (exceptions thrown by it terminate the program)
+struct Job {
+	struct promise_type {
+		Job get_return_object() {
+			return {};
+		}
+
+		std::suspend_never initial_suspend() noexcept {
+			return {};
+		}
+
+		std::suspend_never final_suspend() noexcept {
+			return {};
+		}
+
+		void return_void() {}
+
+		void unhandled_exception() {
+			std::terminate();
+		}
+	};
+};
+
+// one-shot event, set once and awaited by any number of coroutines
+class CompletionEvent {
+
+public:
+
+	// a coroutine waiting for the event: a node of an intrusive list, kept
+	// in the frame of the coroutine, fired (once) when the event is set
+	struct Waiter {
+		Waiter *next = nullptr;
+		void (*fire)(Waiter*) = nullptr;
+	};
+
+private:
+
+	// this once set, otherwise the last waiter added (nullptr if none)
+	std::atomic<void*> state{nullptr};
+
+public:
+	CompletionEvent() = default;
+
+	CompletionEvent(const CompletionEvent&) = delete;
+	CompletionEvent& operator=(const CompletionEvent&) = delete;
+
+	bool is_set() const {
+		return state.load(std::memory_order_acquire) == this;
+	}
+
+	// adds waiter to the ones to fire, returns false (waiter not added) if
+	// the event is already set
+	bool add(Waiter *waiter) {
+		void *old = state.load(std::memory_order_acquire);
+		do {
+			if (old == this)
+				return false;
+			waiter->next = static_cast<Waiter*>(old);
+		} while (!state.compare_exchange_weak(old, waiter,
+			std::memory_order_release, std::memory_order_acquire));
+		return true;
+	}
+
+	// sets the event and fires the waiters added so far
+	void set() {
+		void *old = state.exchange(this, std::memory_order_acq_rel);
+		if (old == this)
+			return;
+		Waiter *waiter = static_cast<Waiter*>(old);
+		while (waiter) {
+			Waiter *next = waiter->next; // the waiter may be gone once fired
+			waiter->fire(waiter);
+			waiter = next;
+		}
+	}
+};
+
+// awaitable of when_all: a waiter on each event and a count of the events
+// not set yet, plus one for the awaiting thread while it adds the waiters;
+// whoever brings the count to zero resumes the coroutine
+template <std::size_t n>
+class WhenAll {
+
+private:
+
+	struct Link : CompletionEvent::Waiter {
+		WhenAll *parent = nullptr;
+	};
+
+	ThreadPool &pool;
+	std::array<CompletionEvent*, n> events;
+	std::array<Link, n> links;
+	std::atomic<uint32_t> pending{0};
+	std::coroutine_handle<> handle;
+
+	static void fire(CompletionEvent::Waiter *waiter) {
+		WhenAll *self = static_cast<Link*>(waiter)->parent;
+		if (self->pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+			self->pool.resume(self->handle);
+	}
+
+public:
+	WhenAll(ThreadPool &pool_, std::array<CompletionEvent*, n> events_) :
+		pool(pool_),
+		events(events_) {}
+
+	WhenAll(const WhenAll&) = delete;
+	WhenAll& operator=(const WhenAll&) = delete;
+
+	// no suspension if all the events are set and the coroutine is
+	// already running on the pool
+	bool await_ready() const {
+		if (!pool.in_pool())
+			return false;
+		for (const CompletionEvent *event : events)
+			if (!event->is_set())
+				return false;
+		return true;
+	}
+
+	bool await_suspend(std::coroutine_handle<> handle_) {
+		handle = handle_;
+		pending.store(n+1, std::memory_order_relaxed);
+		uint32_t done = 1; // the awaiting thread, and the events already set
+		for (std::size_t e=0; e<n; ++e) {
+			links[e].parent = this;
+			links[e].fire = fire;
+			if (!events[e]->add(&links[e]))
+				++done;
+		}
+		// if some event is not set, the coroutine may be resumed (and this
+		// destroyed) by another thread as soon as the count is decremented
+		if (pending.fetch_sub(done, std::memory_order_acq_rel) != done)
+			return true;
+		if (pool.in_pool())
+			return false; // all set, go on in this task
+		pool.resume(handle);
+		return true;
+	}
+
+	void await_resume() const {}
+};
+
+// awaitable resuming the coroutine on pool once all the events are set
+template <typename ... Events>
+WhenAll<sizeof...(Events)> when_all(ThreadPool &pool, Events & ... events) {
+	return WhenAll<sizeof...(Events)>(pool, {&events...});
+}
+
+#endif
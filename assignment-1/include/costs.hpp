@@ -0,0 +1,198 @@
+#ifndef COSTS_HPP
+#define COSTS_HPP
+
+#include <cstdint>
+#include <cmath>
+#include <string>
+#include <fstream>
+#include <stdexcept>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <packedMatrix.hpp>
+
+// Costs of the elements of the wavefront (nanoseconds of busy waiting in
+// wavefront.cpp): drawn from a distribution or read from a cost file.
+
+// counter-based random numbers: the counter-th number of a stream is a hash
+// (the splitmix64 finalizer) of both, so that the numbers of any element
+// can be drawn by any thread without state, and the costs do not depend on
+// how the elements are split among the threads
+inline uint64_t counter_random(const uint64_t &stream, const uint64_t &counter) {
+	uint64_t z = stream*0x9e3779b97f4a7c15 + counter*0xd1b54a32d192ed03;
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+	return z ^ (z >> 31);
+}
+
+// same, as a double uniform in [0, 1)
+inline double counter_uniform(const uint64_t &stream, const uint64_t &counter) {
+	return (counter_random(stream, counter) >> 11) * 0x1.0p-53;
+}
+
+enum class CostDistribution {
+	UNIFORM,     // uniform in [min, max]
+	EXPONENTIAL, // min plus an exponential of mean (max-min)/4, up to max
+	BAND,        // hot bands near the main diagonal: uniform in
+	             // [min, max] on the main diagonal, the part above min
+	             // shrinking as 1/(k+1) on the k-th one
+	LINEAR,      // growing with k: uniform in [min, min+(max-min)(k+1)/N]
+	BIMODAL      // 90% in the lowest tenth of [min, max], 10% in the highest
+};
+
+// the distribution with the given name, as in the options of wavefront
+inline CostDistribution cost_distribution(const std::string &name) {
+	if (name == "uniform")
+		return CostDistribution::UNIFORM;
+	if (name == "exponential")
+		return CostDistribution::EXPONENTIAL;
+	if (name == "band")
+		return CostDistribution::BAND;
+	if (name == "linear")
+		return CostDistribution::LINEAR;
+	if (name == "bimodal")
+		return CostDistribution::BIMODAL;
+	throw std::invalid_argument("unknown cost distribution `" + name + "`");
+}
+
+// cost(k, i) is the cost of the i-th element of the k-th diagonal of an
+// NxN matrix, drawn from the distribution with the numbers 2(kN+i) and
+// 2(kN+i)+1 of the stream seed
+class CostGenerator {
+
+private:
+
+	CostDistribution distribution;
+	int64_t min;
+	int64_t max;
+	uint64_t N;
+	uint64_t seed;
+
+	// integer uniform in [low, high], from u in [0, 1)
+	static int64_t uniform(const double &u, const double &low,
+		const double &high) {
+		return static_cast<int64_t>(low + u*(high-low+1));
+	}
+
+public:
+	CostGenerator(CostDistribution distribution_, int min_, int max_,
+		uint64_t N_, uint64_t seed_) :
+		distribution(distribution_),
+		min(std::min(min_, max_)),
+		max(std::max(min_, max_)),
+		N(N_),
+		seed(seed_) {}
+
+	int operator()(const uint64_t &k, const uint64_t &i) const {
+		const double u = counter_uniform(seed, 2*(k*N+i));
+		const double v = counter_uniform(seed, 2*(k*N+i)+1);
+		const double span = max-min;
+		int64_t cost = min;
+		switch (distribution) {
+			case CostDistribution::UNIFORM:
+				cost = uniform(u, min, max);
+				break;
+			case CostDistribution::EXPONENTIAL:
+				cost = min + static_cast<int64_t>(-std::log1p(-u)*span/4);
+				break;
+			case CostDistribution::BAND:
+				cost = uniform(u, min, min+span/(k+1));
+				break;
+			case CostDistribution::LINEAR:
+				cost = uniform(u, min, min+span*(k+1)/N);
+				break;
+			case CostDistribution::BIMODAL:
+				cost = (v < 0.9) ? uniform(u, min, min+span/10) :
+					uniform(u, max-span/10, max);
+				break;
+		}
+		return static_cast<int>(std::clamp(cost, min, max));
+	}
+};
+
+// Cost file: the order N of the matrix (uint64_t) followed by the
+// N(N+1)/2 costs (int32_t) diagonal by diagonal, as in PackedMatrix, in
+// the byte order of the machine.
+
+// writes the costs of M to a cost file
+inline void write_costs(const std::string &file_name,
+	const PackedMatrix<int> &M) {
+	static_assert(sizeof(int) == sizeof(int32_t), "costs are 32-bit");
+	std::ofstream file(file_name, std::ios_base::binary);
+	const uint64_t N = M.order();
+	file.write(reinterpret_cast<const char*>(&N), sizeof(N));
+	file.write(reinterpret_cast<const char*>(M.diagonal(0)),
+		M.size()*sizeof(int32_t));
+	if (!file)
+		throw std::runtime_error("cannot write cost file `" + file_name + "`");
+}
+
+// a cost file mapped in memory (read-only): the size implied by the order
+// in the header is checked before mapping it, and all the costs must be
+// non-negative (they are read once for that, then from the page cache)
+class MappedCosts {
+
+private:
+
+	void *data = MAP_FAILED;
+	uint64_t length = 0;
+	uint64_t N = 0;
+	const int32_t *costs = nullptr;
+
+public:
+	explicit MappedCosts(const std::string &file_name) {
+		int fd = open(file_name.c_str(), O_RDONLY);
+		struct stat info;
+		if (fd < 0 || fstat(fd, &info) != 0) {
+			if (fd >= 0)
+				close(fd);
+			throw std::runtime_error("cannot open cost file `" + file_name + "`");
+		}
+		length = info.st_size;
+
+		// header plus N(N+1)/2 costs, unless computing it overflows
+		uint64_t elements, expected;
+		bool valid = pread(fd, &N, sizeof(N), 0) == sizeof(N) &&
+			!__builtin_add_overflow(N, 1, &elements) &&
+			!__builtin_mul_overflow(N, elements, &elements) &&
+			!__builtin_mul_overflow(elements/2, sizeof(int32_t), &expected) &&
+			!__builtin_add_overflow(expected, sizeof(uint64_t), &expected) &&
+			expected == length;
+		if (valid)
+			data = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+		close(fd); // the mapping stays valid
+		if (!valid)
+			throw std::runtime_error("invalid cost file `" + file_name + "`");
+		if (data == MAP_FAILED)
+			throw std::runtime_error("cannot map cost file `" + file_name + "`");
+
+		costs = reinterpret_cast<const int32_t*>(
+			static_cast<const char*>(data)+sizeof(uint64_t));
+		if (std::any_of(costs, costs+elements/2,
+			[](const int32_t &cost) { return cost < 0; })) {
+			munmap(data, length);
+			throw std::runtime_error("negative cost in cost file `" +
+				file_name + "`");
+		}
+	}
+
+	~MappedCosts() {
+		munmap(data, length);
+	}
+
+	MappedCosts(const MappedCosts&) = delete;
+	MappedCosts& operator=(const MappedCosts&) = delete;
+
+	// cost of the i-th element of the k-th diagonal
+	int operator()(const uint64_t &k, const uint64_t &i) const {
+		return costs[k*N - k*(k-1)/2 + i];
+	}
+
+	uint64_t order() const {
+		return N;
+	}
+};
+
+#endif
@@ -0,0 +1,107 @@
+#ifndef DOTMATRIX_HPP
+#define DOTMATRIX_HPP
+
+#include <cstdint>
+#include <cmath>
+#include <vector>
+#include <affinity.hpp>
+#if defined(__AVX512F__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+// dot product of two vectors of n doubles, with AVX-512 or AVX2 when the
+// target supports them (two accumulators to hide the latency of the FMAs),
+// else with the scalar loop
+inline double simd_dot(const double *a, const double *b, const uint64_t n) {
+	uint64_t i = 0;
+	double sum = 0;
+#if defined(__AVX512F__)
+	__m512d acc0 = _mm512_setzero_pd(), acc1 = _mm512_setzero_pd();
+	for (; i+16<=n; i+=16) {
+		acc0 = _mm512_fmadd_pd(_mm512_loadu_pd(a+i), _mm512_loadu_pd(b+i), acc0);
+		acc1 = _mm512_fmadd_pd(_mm512_loadu_pd(a+i+8), _mm512_loadu_pd(b+i+8),
+			acc1);
+	}
+	if (i+8 <= n) {
+		acc0 = _mm512_fmadd_pd(_mm512_loadu_pd(a+i), _mm512_loadu_pd(b+i), acc0);
+		i += 8;
+	}
+	alignas(64) double lanes[8];
+	_mm512_store_pd(lanes, _mm512_add_pd(acc0, acc1));
+	for (const double &lane : lanes)
+		sum += lane;
+#elif defined(__AVX2__) && defined(__FMA__)
+	__m256d acc0 = _mm256_setzero_pd(), acc1 = _mm256_setzero_pd();
+	for (; i+8<=n; i+=8) {
+		acc0 = _mm256_fmadd_pd(_mm256_loadu_pd(a+i), _mm256_loadu_pd(b+i), acc0);
+		acc1 = _mm256_fmadd_pd(_mm256_loadu_pd(a+i+4), _mm256_loadu_pd(b+i+4),
+			acc1);
+	}
+	if (i+4 <= n) {
+		acc0 = _mm256_fmadd_pd(_mm256_loadu_pd(a+i), _mm256_loadu_pd(b+i), acc0);
+		i += 4;
+	}
+	__m256d acc = _mm256_add_pd(acc0, acc1);
+	__m128d half = _mm_add_pd(_mm256_castpd256_pd128(acc),
+		_mm256_extractf128_pd(acc, 1));
+	sum = _mm_cvtsd_f64(_mm_add_sd(half, _mm_unpackhi_pd(half, half)));
+#endif
+	for (; i<n; ++i) // remainder (or everything without SIMD)
+		sum += a[i]*b[i];
+	return sum;
+}
+
+// NxN matrix of doubles for the dot-product wavefront: the element (i,j)
+// of the upper triangle, with j=i+k, is the cube root of the dot product
+// of the k elements on its left, (i,i), ..., (i,j-1), with the k elements
+// below it, (i+1,j), ..., (j,j). The matrix is kept both by rows and
+// transposed (by columns) so that both vectors are contiguous, and the
+// elements are written in both copies.
+class DotMatrix {
+
+private:
+
+	uint64_t N;
+	std::vector<double, NoInitAllocator<double>> rows;
+	std::vector<double, NoInitAllocator<double>> cols; // transposed
+
+public:
+	// the main diagonal is set to (i+1)/N, the rest is left unwritten
+	explicit DotMatrix(uint64_t N_) :
+		N(N_),
+		rows(N_*N_),
+		cols(N_*N_) {
+		for (uint64_t i=0; i<N; ++i)
+			rows[i*N+i] = cols[i*N+i] = double(i+1)/N;
+	}
+
+	// computes and stores the i-th element of the k-th upper diagonal (k>0)
+	void compute(const uint64_t &k, const uint64_t &i) {
+		const uint64_t j = i+k;
+		double value = std::cbrt(simd_dot(&rows[i*N+i], &cols[j*N+i+1], k));
+		rows[i*N+j] = value;
+		cols[j*N+i] = value;
+	}
+
+	// the element (i,j)
+	double operator()(const uint64_t &i, const uint64_t &j) const {
+		return rows[i*N+j];
+	}
+
+	uint64_t order() const {
+		return N;
+	}
+
+	// whether the upper triangles of the two matrices are equal
+	bool operator==(const DotMatrix &other) const {
+		if (N != other.N)
+			return false;
+		for (uint64_t i=0; i<N; ++i)
+			for (uint64_t j=i; j<N; ++j)
+				if (rows[i*N+j] != other.rows[i*N+j])
+					return false;
+		return true;
+	}
+};
+
+#endif
@@ -0,0 +1,140 @@
+#ifndef EXECUTOR_HPP
+#define EXECUTOR_HPP
+
+#include <cstdint>
+#include <atomic>
+#include <array>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <type_traits>
+#include <threadPool.hpp>
+#include <affinity.hpp>
+#include <spin.hpp>
+#include <trace.hpp>
+
+// Persistent runtime for repeated wavefront solves: T worker threads,
+// created once and pinned to cpus (if not empty), run the SPMD parts of
+// the static algorithms (run), and a thread pool with the same placement
+// runs the task-based ones (pool, or pool(backend) for another backend,
+// e.g. the priority one for the critical-path scheduling). Nothing is
+// created per solve, idle workers poll idle.spins times and then sleep
+// until the next run.
+class Executor {
+
+private:
+
+	const uint32_t T;
+	const std::vector<int> cpus;
+	const ThreadPool::Backend backend;
+	const ThreadPool::IdlePolicy idle;
+	const bool collect_stats; // of the pool
+
+	std::vector<std::thread> workers;
+	// by backend, created on first use
+	std::array<std::unique_ptr<ThreadPool>, ThreadPool::backends> task_pools;
+
+	// the current job, published by the increment of generation
+	void (*invoke)(void *job, uint32_t id) = nullptr;
+	void *job = nullptr;
+	bool stop = false;
+
+	alignas(64) std::atomic<uint64_t> generation{0};
+	alignas(64) std::atomic<uint32_t> pending{0}; // workers still running
+
+	void worker_loop(uint32_t id) {
+		pin_thread(cpus, id);
+		if (TRACE) trace_thread_name("worker " + std::to_string(id));
+		uint64_t seen = 0;
+		while (true) {
+			for (uint32_t s=0; s<idle.spins &&
+				generation.load(std::memory_order_acquire) == seen; ++s)
+				cpu_relax();
+			generation.wait(seen, std::memory_order_acquire);
+			seen = generation.load(std::memory_order_acquire);
+			if (stop)
+				return;
+			invoke(job, id);
+			if (pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+				pending.notify_one();
+		}
+	}
+
+public:
+	Executor(uint32_t T_,
+		ThreadPool::Backend backend_=ThreadPool::Backend::CENTRAL,
+		ThreadPool::IdlePolicy idle_=ThreadPool::IdlePolicy(),
+		std::vector<int> cpus_={},
+		bool collect_stats_=false) :
+		T(T_),
+		cpus(std::move(cpus_)),
+		backend(backend_),
+		idle(idle_),
+		collect_stats(collect_stats_) {
+
+		for (uint32_t id=0; id<T; ++id)
+			workers.emplace_back(&Executor::worker_loop, this, id);
+	}
+
+	~Executor() {
+		stop = true;
+		generation.fetch_add(1, std::memory_order_release);
+		generation.notify_all();
+		for (auto &worker : workers)
+			worker.join();
+	}
+
+	Executor(const Executor&) = delete;
+	Executor& operator=(const Executor&) = delete;
+
+	// calls func(id) on the id-th worker, for all of them at the same time,
+	// and returns when all the calls have returned (not reentrant)
+	template <typename Func>
+	void run(Func && func) {
+		using Callable = std::remove_reference_t<Func>;
+		job = const_cast<void*>(static_cast<const void*>(&func));
+		invoke = [] (void *f, uint32_t id) {
+			(*static_cast<Callable*>(f))(id);
+		};
+		pending.store(T, std::memory_order_relaxed);
+		generation.fetch_add(1, std::memory_order_release);
+		generation.notify_all();
+
+		uint32_t left;
+		while ((left = pending.load(std::memory_order_acquire)) != 0)
+			pending.wait(left, std::memory_order_acquire);
+	}
+
+	// pool of T threads placed as the workers, for the task-based algorithms
+	ThreadPool& pool() {
+		return pool(backend);
+	}
+
+	// same, with the given backend
+	ThreadPool& pool(ThreadPool::Backend backend_) {
+		auto &task_pool = task_pools[static_cast<int>(backend_)];
+		if (!task_pool)
+			task_pool = std::make_unique<ThreadPool>(T, backend_, idle, cpus,
+				collect_stats);
+		return *task_pool;
+	}
+
+	// statistics of all the pools created so far, merged
+	ThreadPool::Stats stats() const {
+		ThreadPool::Stats merged;
+		for (const auto &task_pool : task_pools)
+			if (task_pool)
+				merged.merge(task_pool->stats());
+		return merged;
+	}
+
+	uint32_t size() const {
+		return T;
+	}
+
+	const std::vector<int>& placement() const {
+		return cpus;
+	}
+};
+
+#endif
@@ -0,0 +1,105 @@
+#ifndef MPMCRING_HPP
+#define MPMCRING_HPP
+
+#include <cstdint>
+#include <atomic>
+#include <memory>
+
+// Bounded multi-producer multi-consumer queue (D. Vyukov's algorithm).
+// Each slot of the circular array has a sequence number telling whether it
+// is free for the push of the current lap (sequence == position) or full
+// for its pop (sequence == position+1). Producers and consumers claim a
+// position with a CAS on their own cursor and then hand the slot over by
+// storing the next sequence number, without locks: they only contend with
+// the threads on the same side, and only on full or empty they give up.
+// Items are moved in and out of fixed slots, nothing is allocated after
+// the construction.
+template <typename Item>
+class MPMCRing {
+
+private:
+
+	// a slot per cache line (more than one if the item is larger)
+	struct alignas(64) Slot {
+		std::atomic<uint64_t> sequence;
+		Item item;
+	};
+
+	const uint64_t mask;
+	std::unique_ptr<Slot[]> slots;
+
+	// the cursors are written by different threads
+	alignas(64) std::atomic<uint64_t> tail{0}; // next position to push
+	alignas(64) std::atomic<uint64_t> head{0}; // next position to pop
+
+	static uint64_t round_up(uint64_t capacity) {
+		uint64_t c = 1;
+		while (c < capacity)
+			c <<= 1;
+		return c;
+	}
+
+public:
+	// the capacity is rounded up to a power of two
+	explicit MPMCRing(uint64_t capacity=4096) :
+		mask(round_up(capacity)-1),
+		slots(new Slot[mask+1]) {
+		for (uint64_t i=0; i<=mask; ++i)
+			slots[i].sequence.store(i, std::memory_order_relaxed);
+	}
+
+	MPMCRing(const MPMCRing&) = delete;
+	MPMCRing& operator=(const MPMCRing&) = delete;
+
+	// moves item into the ring, returns false (item untouched) if it is full
+	bool try_push(Item &item) {
+		uint64_t pos = tail.load(std::memory_order_relaxed);
+		while (true) {
+			Slot &slot = slots[pos & mask];
+			uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+			int64_t diff = int64_t(sequence)-int64_t(pos);
+			if (diff == 0) {
+				// the slot is free, claim the position
+				if (tail.compare_exchange_weak(pos, pos+1,
+					std::memory_order_relaxed)) {
+					slot.item = std::move(item);
+					slot.sequence.store(pos+1, std::memory_order_release);
+					return true;
+				}
+			}
+			else if (diff < 0)
+				return false; // not popped yet in the previous lap: full
+			else
+				pos = tail.load(std::memory_order_relaxed); // lost the race
+		}
+	}
+
+	// moves the oldest item out of the ring, returns false if it is empty
+	bool try_pop(Item &item) {
+		uint64_t pos = head.load(std::memory_order_relaxed);
+		while (true) {
+			Slot &slot = slots[pos & mask];
+			uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+			int64_t diff = int64_t(sequence)-int64_t(pos+1);
+			if (diff == 0) {
+				// the slot is full, claim the position
+				if (head.compare_exchange_weak(pos, pos+1,
+					std::memory_order_relaxed)) {
+					item = std::move(slot.item);
+					slot.sequence.store(pos+mask+1, std::memory_order_release);
+					return true;
+				}
+			}
+			else if (diff < 0)
+				return false; // not pushed yet in this lap: empty
+			else
+				pos = head.load(std::memory_order_relaxed); // lost the race
+		}
+	}
+
+	uint64_t capacity() const {
+		return mask+1;
+	}
+};
+
+#endif
@@ -0,0 +1,63 @@
+#ifndef PACKEDMATRIX_HPP
+#define PACKEDMATRIX_HPP
+
+#include <cstdint>
+#include <vector>
+#include <affinity.hpp>
+
+// Upper triangle of an NxN matrix stored diagonal by diagonal: the N-k
+// elements of the k-th upper diagonal, (0,k), (1,k+1), ..., (N-k-1,N-1),
+// are contiguous and follow the ones of the (k-1)-th diagonal.
+// It takes N(N+1)/2 elements, and a sweep along a diagonal is sequential.
+// The elements are left default-initialized (not written) on allocation.
+template <typename Item>
+class PackedMatrix {
+
+private:
+
+	uint64_t N;
+	std::vector<Item, NoInitAllocator<Item>> elements;
+
+public:
+	explicit PackedMatrix(uint64_t N_) :
+		N(N_),
+		elements(N_*(N_+1)/2) {}
+
+	// position of the first element of the k-th diagonal
+	uint64_t offset(const uint64_t &k) const {
+		return k*N - k*(k-1)/2;
+	}
+
+	// position of the i-th element of the k-th diagonal, i.e. (i,i+k)
+	uint64_t index(const uint64_t &k, const uint64_t &i) const {
+		return offset(k) + i;
+	}
+
+	Item& operator()(const uint64_t &k, const uint64_t &i) {
+		return elements[index(k, i)];
+	}
+
+	const Item& operator()(const uint64_t &k, const uint64_t &i) const {
+		return elements[index(k, i)];
+	}
+
+	Item* diagonal(const uint64_t &k) {
+		return elements.data() + offset(k);
+	}
+
+	const Item* diagonal(const uint64_t &k) const {
+		return elements.data() + offset(k);
+	}
+
+	// number of rows (and columns) of the square matrix
+	uint64_t order() const {
+		return N;
+	}
+
+	// number of stored elements
+	uint64_t size() const {
+		return elements.size();
+	}
+};
+
+#endif
@@ -0,0 +1,86 @@
+#ifndef SPIN_HPP
+#define SPIN_HPP
+
+#include <cstdint>
+#include <thread>
+#include <chrono>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#include <x86intrin.h>
+#endif
+
+// hint to the core that the thread is busy-waiting
+inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+	_mm_pause();
+#elif defined(__aarch64__)
+	asm volatile("yield");
+#endif
+}
+
+// spins until ready() holds, yielding the core after a while
+// so that oversubscribed threads still make progress
+template <typename Predicate>
+inline void spin_until(Predicate && ready) {
+	for (uint32_t spins=0; !ready(); ++spins) {
+		if (spins < 1024)
+			cpu_relax();
+		else
+			std::this_thread::yield();
+	}
+}
+
+// calibration of the time stamp counter, measured once against
+// steady_clock (the first call busy-waits for about 10 ms, better done
+// before anything is timed)
+struct TscCalibration {
+	double ticks_per_ns = 0; // 0 without a time stamp counter
+	uint64_t read_ticks = 0; // cost of a read, the overshoot of a wait
+};
+
+inline const TscCalibration& tsc_calibration() {
+	static const TscCalibration calibration = [] ( ) -> TscCalibration {
+		TscCalibration c;
+#if defined(__x86_64__) || defined(__i386__)
+		auto start = std::chrono::steady_clock::now();
+		uint64_t tsc_start = __rdtsc();
+		while (std::chrono::steady_clock::now()-start <
+			std::chrono::milliseconds(10));
+		uint64_t ticks = __rdtsc()-tsc_start;
+		double elapsed = std::chrono::duration<double, std::nano>(
+			std::chrono::steady_clock::now()-start).count();
+		c.ticks_per_ns = ticks/elapsed;
+
+		const uint64_t reads = 1000;
+		tsc_start = __rdtsc();
+		for (uint64_t r=0; r<reads; ++r)
+			__rdtsc();
+		c.read_ticks = (__rdtsc()-tsc_start)/reads;
+#endif
+		return c;
+	}();
+	return calibration;
+}
+
+// busy-waits for duration reading the time stamp counter (a few ns per
+// read, and no pause in between), instead of steady_clock (a vDSO call
+// of tens of ns), so that waits down to 100 ns are accurate; the counter
+// must be invariant (constant rate on all the cores), as on recent x86;
+// returns at once if duration is not positive
+inline void spin_for(std::chrono::nanoseconds duration) {
+	if (duration.count() <= 0)
+		return;
+#if defined(__x86_64__) || defined(__i386__)
+	const uint64_t start = __rdtsc();
+	const TscCalibration &c = tsc_calibration();
+	const uint64_t ticks = duration.count()*c.ticks_per_ns;
+	if (ticks <= c.read_ticks)
+		return;
+	while (__rdtsc()-start < ticks-c.read_ticks);
+#else
+	auto end = std::chrono::steady_clock::now() + duration;
+	while (std::chrono::steady_clock::now() < end);
+#endif
+}
+
+#endif
@@ -0,0 +1,187 @@
+#ifndef TASK_HPP
+#define TASK_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <new>
+#include <memory>
+#include <utility>
+#include <type_traits>
+
+// Move-only void() callable. Callables up to inline_size bytes are stored
+// in place (no heap allocation), larger ones fall back to the heap.
+// A task takes a cache line, timestamp included.
+class Task {
+
+public:
+
+	static constexpr std::size_t inline_size = 40;
+
+private:
+
+	alignas(std::max_align_t) unsigned char storage[inline_size];
+	void (*invoke)(void*) = nullptr;
+	// moves the callable from src to dst (if not null) and destroys src
+	void (*manage)(void *dst, void *src) = nullptr;
+
+public:
+
+	// when the task was enqueued (ns), set by a pool collecting statistics
+	uint64_t enqueued = 0;
+
+private:
+
+	template <typename Func>
+	static constexpr bool fits_inline =
+		sizeof(Func) <= inline_size &&
+		alignof(Func) <= alignof(std::max_align_t) &&
+		std::is_nothrow_move_constructible_v<Func>;
+
+	template <typename Func>
+	static void invoke_inline(void *callable) {
+		(*static_cast<Func*>(callable))();
+	}
+
+	template <typename Func>
+	static void manage_inline(void *dst, void *src) {
+		if (dst)
+			new (dst) Func(std::move(*static_cast<Func*>(src)));
+		static_cast<Func*>(src)->~Func();
+	}
+
+	template <typename Func>
+	static void invoke_heap(void *callable) {
+		(**static_cast<Func**>(callable))();
+	}
+
+	template <typename Func>
+	static void manage_heap(void *dst, void *src) {
+		if (dst)
+			*static_cast<Func**>(dst) = *static_cast<Func**>(src);
+		else
+			delete *static_cast<Func**>(src);
+	}
+
+	void reset() {
+		if (manage)
+			manage(nullptr, storage);
+		invoke = nullptr;
+		manage = nullptr;
+	}
+
+public:
+	Task() = default;
+
+	template <typename Func, typename Callable=std::decay_t<Func>,
+			  typename=std::enable_if_t<!std::is_same_v<Callable, Task>>>
+	Task(Func && func) {
+		if constexpr (fits_inline<Callable>) {
+			new (storage) Callable(std::forward<Func>(func));
+			invoke = &invoke_inline<Callable>;
+			manage = &manage_inline<Callable>;
+		}
+		else {
+			*reinterpret_cast<Callable**>(storage) =
+				new Callable(std::forward<Func>(func));
+			invoke = &invoke_heap<Callable>;
+			manage = &manage_heap<Callable>;
+		}
+	}
+
+	Task(Task && other) noexcept :
+		invoke(other.invoke),
+		manage(other.manage),
+		enqueued(other.enqueued) {
+		if (manage)
+			manage(storage, other.storage);
+		other.invoke = nullptr;
+		other.manage = nullptr;
+	}
+
+	Task& operator=(Task && other) noexcept {
+		if (this != &other) {
+			reset();
+			enqueued = other.enqueued;
+			invoke = other.invoke;
+			manage = other.manage;
+			if (manage)
+				manage(storage, other.storage);
+			other.invoke = nullptr;
+			other.manage = nullptr;
+		}
+		return *this;
+	}
+
+	Task(const Task&) = delete;
+	Task& operator=(const Task&) = delete;
+
+	~Task() {
+		reset();
+	}
+
+	void operator()() {
+		invoke(storage);
+	}
+
+	explicit operator bool() const {
+		return invoke != nullptr;
+	}
+};
+
+// FIFO queue of tasks on a circular buffer: the slots are allocated once
+// and recycled, the buffer doubles only when it is full. Not thread-safe.
+class TaskRing {
+
+private:
+
+	std::unique_ptr<Task[]> slots;
+	uint64_t mask;
+	uint64_t head; // next slot to pop
+	uint64_t count;
+
+	void grow() {
+		uint64_t capacity = mask+1;
+		std::unique_ptr<Task[]> bigger(new Task[2*capacity]);
+		for (uint64_t i=0; i<count; ++i)
+			bigger[i] = std::move(slots[(head+i) & mask]);
+		slots = std::move(bigger);
+		mask = 2*capacity-1;
+		head = 0;
+	}
+
+public:
+	explicit TaskRing(uint64_t capacity=1024) : head(0), count(0) {
+		// the capacity must be a power of two
+		uint64_t c = 1;
+		while (c < capacity) c <<= 1;
+		slots.reset(new Task[c]);
+		mask = c-1;
+	}
+
+	void push(Task && task) {
+		if (count == mask+1)
+			grow();
+		slots[(head+count) & mask] = std::move(task);
+		count++;
+	}
+
+	// returns false if the queue is empty
+	bool pop(Task &task) {
+		if (count == 0)
+			return false;
+		task = std::move(slots[head]);
+		head = (head+1) & mask;
+		count--;
+		return true;
+	}
+
+	bool empty() const {
+		return count == 0;
+	}
+
+	uint64_t size() const {
+		return count;
+	}
+};
+
+#endif
@@ -2,30 +2,211 @@
 #define THREADPOOL_HPP
 
 #include <cstdint>
+#include <atomic>
+#include <algorithm>
+#include <memory>
 #include <future>
 #include <vector>
-#include <queue>
 #include <thread>
 #include <mutex>
 #include <condition_variable>
 #include <functional>
+#include <chrono>
+#include <coroutine>
+#include <spin.hpp>
+#include <trace.hpp>
+#include <task.hpp>
+#include <affinity.hpp>
+#include <workStealingDeque.hpp>
+#include <mpmcRing.hpp>
 
 class ThreadPool {
 
+public:
+
+	// how tasks are handed over to the threads
+	enum class Backend {
+		CENTRAL,       // a single queue guarded by a mutex
+		WORK_STEALING, // per-thread deques, idle threads steal
+		PRIORITY,      // per-thread heaps, the highest priority is served
+		RING           // a single lock-free bounded ring (MPMCRing)
+	};
+
+	// number of backends (RING is the last one)
+	static constexpr std::size_t backends =
+		static_cast<std::size_t>(Backend::RING)+1;
+
+	// what a thread finding no task does before sleeping on the condition
+	// variable: it polls the queue spins times with a pause in between,
+	// then yields times yielding the core in between
+	struct IdlePolicy {
+		uint32_t spins = 0;
+		uint32_t yields = 0;
+	};
+
+	// buckets of the latency histogram: the b-th one counts the tasks
+	// started between 2^b and 2^(b+1) ns after being enqueued
+	static constexpr uint32_t latency_buckets = 32;
+
+	// snapshot of the statistics of a pool collecting them
+	struct Stats {
+		std::vector<uint64_t> tasks;   // executed by each thread
+		uint64_t queue_high_water = 0; // most tasks enqueued and not started
+		double mutex_time = 0;         // blocked acquiring the mutex (s)
+		double sleep_time = 0;         // sleeping on the condition variable (s)
+		std::vector<uint64_t> latency; // enqueue-to-start histogram
+
+		// upper bound (ns) of the enqueue-to-start latency of a fraction
+		// p of the tasks, 0 if there are none
+		double latency_percentile(double p) const {
+			uint64_t total = 0, seen = 0;
+			for (const uint64_t &count : latency)
+				total += count;
+			for (uint32_t b=0; b<latency.size() && total>0; ++b) {
+				seen += latency[b];
+				if (seen >= p*total)
+					return double(uint64_t(2) << b);
+			}
+			return 0;
+		}
+
+		// adds the statistics of another pool (of the same size, the tasks
+		// of the id-th threads are summed)
+		void merge(const Stats &other) {
+			tasks.resize(std::max(tasks.size(), other.tasks.size()), 0);
+			for (uint64_t id=0; id<other.tasks.size(); ++id)
+				tasks[id] += other.tasks[id];
+			queue_high_water = std::max(queue_high_water,
+				other.queue_high_water);
+			mutex_time += other.mutex_time;
+			sleep_time += other.sleep_time;
+			latency.resize(std::max(latency.size(), other.latency.size()), 0);
+			for (uint64_t b=0; b<other.latency.size(); ++b)
+				latency[b] += other.latency[b];
+		}
+	};
+
 private:
 
-	// storage for threads and tasks
+	// storage for threads and tasks (the ring backend uses the queue
+	// only when the ring is full)
 	std::vector<std::thread> threads;
-	std::queue<std::function<void(void)>> tasks;
+	TaskRing tasks;
+	std::unique_ptr<MPMCRing<Task>> ring;
 
 	// primitives for signaling
 	std::mutex mutex;
 	std::condition_variable cv;
 
 	// the state of the thread pool
-	bool stop_pool;
+	std::atomic<bool> stop_pool;
 	uint32_t active_threads;
 	const uint32_t capacity;
+	const Backend backend;
+	const IdlePolicy idle;
+	const std::vector<int> cpus; // where to pin the threads, if not empty
+	const bool collect_stats;
+
+	// statistics of a thread, written only by the thread itself (relaxed
+	// loads and stores, no read-modify-write) and read by stats()
+	struct alignas(64) ThreadStats {
+		std::atomic<uint64_t> tasks{0};
+		std::atomic<uint64_t> queue_high_water{0};
+		std::atomic<uint64_t> mutex_ns{0};
+		std::atomic<uint64_t> sleep_ns{0};
+		std::atomic<uint64_t> latency[latency_buckets] = {};
+
+		static void add(std::atomic<uint64_t> &counter, uint64_t value) {
+			counter.store(counter.load(std::memory_order_relaxed)+value,
+				std::memory_order_relaxed);
+		}
+
+		// a task started after waiting latency ns with length tasks queued
+		void started(uint64_t latency_ns, uint64_t length) {
+			add(tasks, 1);
+			if (length > queue_high_water.load(std::memory_order_relaxed))
+				queue_high_water.store(length, std::memory_order_relaxed);
+			uint32_t b = 0;
+			while (b+1 < latency_buckets && (latency_ns >> (b+1)))
+				b++;
+			add(latency[b], 1);
+		}
+	};
+	std::unique_ptr<ThreadStats[]> thread_stats;
+
+	static uint64_t now_ns() {
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	// statistics of the calling thread, if it belongs to the pool
+	ThreadStats* local_stats() {
+		return (collect_stats && local_pool == this) ?
+			&thread_stats[local_id] : nullptr;
+	}
+
+	// a task in a work-stealing deque, taken from the slab of its owner
+	struct alignas(64) TaskNode {
+		Task task;
+		TaskNode *next;
+		uint32_t owner;
+	};
+
+	// a task of the priority backend
+	struct PrioritizedTask {
+		uint64_t priority;
+		Task task;
+
+		bool operator<(const PrioritizedTask &other) const {
+			return priority < other.priority;
+		}
+	};
+
+	// per-thread state of the work-stealing and priority backends: tasks
+	// enqueued by a thread of the pool go to its own deque (heap), the ones
+	// enqueued from outside are spread round-robin over the inboxes (heaps)
+	struct alignas(64) Worker {
+		WorkStealingDeque<TaskNode*> deque;
+		std::mutex inbox_mutex;
+		TaskRing inbox;
+		std::atomic<uint64_t> inbox_size{0};
+		uint64_t seed; // for the choice of the victims
+
+		// slab of task nodes: nodes released by the owner go back to
+		// the local list, the ones released by others to the remote one
+		std::vector<std::unique_ptr<TaskNode[]>> chunks;
+		TaskNode *local_free = nullptr;
+		alignas(64) std::atomic<TaskNode*> remote_free{nullptr};
+
+		// max-heap of the priority backend, with its top priority plus
+		// one (0 if empty) to be read without the lock
+		alignas(64) std::mutex heap_mutex;
+		std::vector<PrioritizedTask> heap;
+		std::atomic<uint64_t> top{0};
+	};
+	std::vector<std::unique_ptr<Worker>> workers;
+
+	// counters of the idle threads
+	alignas(64) std::atomic<uint64_t> queued{0};     // enqueued, not started
+	// (counted before a task is published, so that a thread taking it
+	// never finds the counter at 0)
+	alignas(64) std::atomic<uint32_t> sleeping{0};   // waiting on cv
+
+	// counters of the work-stealing, priority and ring backends
+	alignas(64) std::atomic<uint64_t> unfinished{0}; // enqueued, not completed
+	alignas(64) std::atomic<uint64_t> next_inbox{0};
+	alignas(64) std::atomic<uint64_t> overflow{0};   // in tasks, ring full
+
+	// the pool (and the id in it) the calling thread belongs to
+	inline static thread_local ThreadPool *local_pool = nullptr;
+	inline static thread_local uint32_t local_id = 0;
+
+	static constexpr uint64_t slab_chunk = 256;
+
+	// default slots of the ring backend, and polls of the ring with a
+	// pause before an idle thread of that backend follows the idle policy
+	static constexpr uint64_t default_ring_slots = 4096;
+	static constexpr uint32_t ring_spins = 1024;
 
 	// custom task factory
 	template <typename Func, typename ... Args,
@@ -48,63 +229,581 @@ private:
 		active_threads--;
 	}
 
+	// polls ready() as dictated by the idle policy,
+	// returns false if it never became true
+	template <typename Predicate>
+	bool idle_wait(Predicate && ready) {
+		for (uint32_t i=0; i<idle.spins; ++i) {
+			if (ready())
+				return true;
+			cpu_relax();
+		}
+		for (uint32_t i=0; i<idle.yields; ++i) {
+			if (ready())
+				return true;
+			std::this_thread::yield();
+		}
+		return ready();
+	}
+
+	// this function is executed by the threads (central backend)
+	void central_loop(uint32_t id) {
+		pin_thread(cpus, id);
+		local_pool = this;
+		local_id = id;
+		if (TRACE) trace_thread_name("pool " + std::to_string(id));
+
+		// this is a placeholder task
+		Task task;
+
+		// wait forever
+		while (true) {
+			uint64_t wait_start = trace_clock();
+
+			// look at the queue for a while before sleeping
+			idle_wait([this] ( ) -> bool {
+				return stop_pool || queued > 0;
+			});
+
+			{
+				// lock this section for waiting
+				uint64_t lock_start = collect_stats ? now_ns() : 0;
+				std::unique_lock<std::mutex>
+					unique_lock(mutex);
+				uint64_t sleep_start = collect_stats ? now_ns() : 0;
+				if (collect_stats)
+					ThreadStats::add(thread_stats[id].mutex_ns,
+						sleep_start-lock_start);
+
+				// actions must be performed on
+				// wake-up if (i) the thread pool
+				// has been stopped, or (ii) there
+				// are still tasks to be processed
+				auto predicate = [this] ( ) -> bool {
+					return (stop_pool) || !(tasks.empty());
+				};
+
+				// wait to be waken up on
+				// aforementioned conditions
+				sleeping++;
+				cv.wait(unique_lock, predicate);
+				sleeping--;
+				if (collect_stats)
+					ThreadStats::add(thread_stats[id].sleep_ns,
+						now_ns()-sleep_start);
+
+				// exit if thread pool stopped
+				// and no tasks to be performed
+				if (stop_pool && tasks.empty())
+					return;
+
+				// else extract task from queue
+				uint64_t length = tasks.size();
+				tasks.pop(task);
+				queued--;
+				before_task_hook();
+				if (collect_stats)
+					thread_stats[id].started(now_ns()-task.enqueued, length);
+			} // here we release the lock
+			trace_event(TraceKind::QUEUE, wait_start);
+
+			// execute the task in parallel
+			task();
+			task = Task();
+
+			{
+				// adjust the thread counter
+				uint64_t lock_start = collect_stats ? now_ns() : 0;
+				std::lock_guard<std::mutex>	lock_guard(mutex);
+				if (collect_stats)
+					ThreadStats::add(thread_stats[id].mutex_ns,
+						now_ns()-lock_start);
+				after_task_hook();
+			} // here we release the lock
+		}
+	}
+
+	// takes a node from the slab of the calling thread
+	TaskNode* alloc_node(uint32_t id) {
+		Worker &self = *workers[id];
+		if (!self.local_free)
+			self.local_free = self.remote_free.exchange(nullptr,
+				std::memory_order_acquire);
+		if (!self.local_free) {
+			self.chunks.emplace_back(new TaskNode[slab_chunk]);
+			TaskNode *chunk = self.chunks.back().get();
+			for (uint64_t i=0; i<slab_chunk; ++i) {
+				chunk[i].owner = id;
+				chunk[i].next = (i+1 < slab_chunk) ? &chunk[i+1] : nullptr;
+			}
+			self.local_free = chunk;
+		}
+		TaskNode *node = self.local_free;
+		self.local_free = node->next;
+		return node;
+	}
+
+	// gives a node back to the slab of its owner
+	void free_node(uint32_t id, TaskNode *node) {
+		node->task = Task();
+		Worker &owner = *workers[node->owner];
+		if (node->owner == id) {
+			node->next = owner.local_free;
+			owner.local_free = node;
+			return;
+		}
+		node->next = owner.remote_free.load(std::memory_order_relaxed);
+		while (!owner.remote_free.compare_exchange_weak(node->next, node,
+			std::memory_order_release, std::memory_order_relaxed));
+	}
+
+	// moves the inbox of a thread to its deque, so that it can be stolen
+	bool drain_inbox(uint32_t id) {
+		Worker &self = *workers[id];
+		if (self.inbox_size.load(std::memory_order_relaxed) == 0)
+			return false;
+
+		std::lock_guard<std::mutex> lock_guard(self.inbox_mutex);
+		bool drained = !self.inbox.empty();
+		TaskNode *node = alloc_node(id);
+		while (self.inbox.pop(node->task)) {
+			self.deque.push(node);
+			node = alloc_node(id);
+		}
+		free_node(id, node);
+		self.inbox_size.store(0, std::memory_order_relaxed);
+		return drained;
+	}
+
+	// takes a task from the inbox of another thread, if it is not busy
+	bool steal_inbox(uint32_t id, Worker &victim, TaskNode* &node) {
+		if (victim.inbox_size.load(std::memory_order_relaxed) == 0)
+			return false;
+
+		std::unique_lock<std::mutex> lock(victim.inbox_mutex, std::try_to_lock);
+		if (!lock.owns_lock() || victim.inbox.empty())
+			return false;
+		node = alloc_node(id);
+		victim.inbox.pop(node->task);
+		victim.inbox_size.store(victim.inbox.size(), std::memory_order_relaxed);
+		return true;
+	}
+
+	// looks for a task in (i) the own deque, (ii) the own inbox
+	// and (iii) the deques and inboxes of random victims
+	bool find_task(uint32_t id, TaskNode* &node) {
+		Worker &self = *workers[id];
+
+		if (self.deque.pop(node))
+			return true;
+		if (drain_inbox(id) && self.deque.pop(node))
+			return true;
+
+		for (uint32_t attempt=0; attempt<2*capacity; ++attempt) {
+			// xorshift64
+			self.seed ^= self.seed << 13;
+			self.seed ^= self.seed >> 7;
+			self.seed ^= self.seed << 17;
+			uint32_t victim = self.seed % capacity;
+			if (victim == id)
+				continue;
+			if (workers[victim]->deque.steal(node) ||
+				steal_inbox(id, *workers[victim], node))
+				return true;
+		}
+		return false;
+	}
+
+	// takes a task of the work-stealing backend (see find_task),
+	// returns false if there is none
+	bool pop_stealing(uint32_t id, Task &task) {
+		TaskNode *node;
+		if (!find_task(id, node))
+			return false;
+		task = std::move(node->task);
+		free_node(id, node);
+		return true;
+	}
+
+	// this function is executed by the threads of the work-stealing,
+	// priority and ring backends: pop(task) takes the next task, false if
+	// there is none; an idle thread polls queued polls times with a pause
+	// in between, then follows the idle policy and then sleeps until a
+	// task is enqueued
+	template <typename Pop>
+	void task_loop(uint32_t id, uint32_t polls, Pop && pop) {
+		pin_thread(cpus, id);
+		local_pool = this;
+		local_id = id;
+		if (TRACE) trace_thread_name("pool " + std::to_string(id));
+
+		// start of the search for the next task
+		uint64_t wait_start = trace_clock();
+		Task task;
+
+		while (true) {
+			if (pop(task)) {
+				uint64_t length = queued.fetch_sub(1);
+				trace_event(TraceKind::QUEUE, wait_start);
+				if (collect_stats)
+					thread_stats[id].started(now_ns()-task.enqueued, length);
+				task();
+				task = Task();
+
+				// the last task wakes up the threads if the pool is stopping
+				if (unfinished.fetch_sub(1) == 1) {
+					std::lock_guard<std::mutex> lock_guard(mutex);
+					if (stop_pool)
+						cv.notify_all();
+				}
+				wait_start = trace_clock();
+				continue;
+			}
+
+			// nothing to take, look for new tasks
+			// for a while, then sleep until one is enqueued
+			bool ready = false;
+			for (uint32_t s=0; s<polls && !(ready = queued > 0); ++s)
+				cpu_relax();
+			if (ready || idle_wait([this] ( ) -> bool { return queued > 0; }))
+				continue;
+			uint64_t lock_start = collect_stats ? now_ns() : 0;
+			std::unique_lock<std::mutex> unique_lock(mutex);
+			uint64_t sleep_start = collect_stats ? now_ns() : 0;
+			sleeping++;
+			cv.wait(unique_lock, [this] ( ) -> bool {
+				return queued > 0 || (stop_pool && unfinished == 0);
+			});
+			sleeping--;
+			if (collect_stats) {
+				ThreadStats::add(thread_stats[id].mutex_ns,
+					sleep_start-lock_start);
+				ThreadStats::add(thread_stats[id].sleep_ns,
+					now_ns()-sleep_start);
+			}
+
+			// exit if thread pool stopped
+			// and no tasks to be performed
+			if (stop_pool && unfinished == 0)
+				return;
+		}
+	}
+
+	// this function is executed by the threads (work-stealing backend)
+	void stealing_loop(uint32_t id) {
+		task_loop(id, 0, [this, id] (Task &task) -> bool {
+			return pop_stealing(id, task);
+		});
+	}
+
+	// you cannot reuse pool after being stopped (with the work-stealing,
+	// priority and ring backends running tasks can still enqueue, the
+	// threads wait for them)
+	void check_running() {
+		if (stop_pool && local_pool != this)
+			throw std::runtime_error("enqueue on stopped ThreadPool");
+	}
+
+	// takes the task with the highest priority among the tops of the heaps
+	// (the own one on ties), returns false if they are all empty
+	bool pop_priority(uint32_t id, Task &task) {
+		while (true) {
+			Worker *best = workers[id].get();
+			uint64_t best_top = best->top.load(std::memory_order_relaxed);
+			for (uint32_t victim=0; victim<capacity; ++victim) {
+				uint64_t top = workers[victim]->top.load(std::memory_order_relaxed);
+				if (top > best_top) {
+					best = workers[victim].get();
+					best_top = top;
+				}
+			}
+			if (best_top == 0)
+				return false;
+
+			std::lock_guard<std::mutex> lock_guard(best->heap_mutex);
+			if (best->heap.empty())
+				continue; // taken by another thread in the meantime
+			std::pop_heap(best->heap.begin(), best->heap.end());
+			task = std::move(best->heap.back().task);
+			best->heap.pop_back();
+			best->top.store(best->heap.empty() ? 0 :
+				best->heap.front().priority+1, std::memory_order_relaxed);
+			return true;
+		}
+	}
+
+	// this function is executed by the threads (priority backend)
+	void priority_loop(uint32_t id) {
+		task_loop(id, 0, [this, id] (Task &task) -> bool {
+			return pop_priority(id, task);
+		});
+	}
+
+	// appends a task to the priority backend, without waking anyone
+	void push_priority(Task && task, uint64_t priority) {
+		check_running();
+		unfinished++;
+		queued++;
+		Worker &worker = *workers[(local_pool == this) ? local_id :
+			next_inbox.fetch_add(1, std::memory_order_relaxed) % capacity];
+		{
+			std::lock_guard<std::mutex> lock_guard(worker.heap_mutex);
+			worker.heap.push_back({priority, std::move(task)});
+			std::push_heap(worker.heap.begin(), worker.heap.end());
+			worker.top.store(worker.heap.front().priority+1,
+				std::memory_order_relaxed);
+		}
+	}
+
+	// takes the oldest task of the ring, or of the overflow queue if the
+	// ring is empty (see push_ring, the tasks of the ring are the oldest),
+	// returns false if both are
+	bool pop_ring(Task &task) {
+		if (ring->try_pop(task))
+			return true;
+		if (overflow.load(std::memory_order_acquire) == 0)
+			return false;
+		std::lock_guard<std::mutex> lock_guard(mutex);
+		if (tasks.empty())
+			return false;
+		tasks.pop(task);
+		overflow--;
+		return true;
+	}
+
+	// this function is executed by the threads (ring backend): the ring
+	// is polled for a while before the idle policy, so that a producer
+	// enqueueing at a high rate finds the threads awake and does not take
+	// the mutex to wake them
+	void ring_loop(uint32_t id) {
+		task_loop(id, ring_spins, [this] (Task &task) -> bool {
+			return pop_ring(task);
+		});
+	}
+
+	// appends a task to the ring backend, without waking anyone: the task
+	// goes to the overflow queue (under the mutex) if the ring is full, and
+	// so do the next ones until the overflow queue is drained, so that the
+	// tasks are taken in order and the ones of the queue are not starved
+	// by the ones refilling the ring
+	void push_ring(Task && task) {
+		check_running();
+		unfinished++;
+		queued++;
+		if (overflow.load(std::memory_order_acquire) != 0 ||
+			!ring->try_push(task)) {
+			ThreadStats *stats = local_stats();
+			uint64_t lock_start = stats ? now_ns() : 0;
+			std::lock_guard<std::mutex> lock_guard(mutex);
+			if (stats)
+				ThreadStats::add(stats->mutex_ns, now_ns()-lock_start);
+			tasks.push(std::move(task));
+			overflow++;
+		}
+	}
+
+	// appends a task to the work-stealing backend, without waking anyone
+	void push_stealing(Task && task) {
+		check_running();
+		unfinished++;
+		queued++;
+		if (local_pool == this) {
+			// no lock, the deque is owned by the calling thread
+			TaskNode *node = alloc_node(local_id);
+			node->task = std::move(task);
+			workers[local_id]->deque.push(node);
+		}
+		else {
+			Worker &worker = *workers[
+				next_inbox.fetch_add(1, std::memory_order_relaxed) % capacity];
+			std::lock_guard<std::mutex> lock_guard(worker.inbox_mutex);
+			worker.inbox.push(std::move(task));
+			worker.inbox_size.store(worker.inbox.size(),
+				std::memory_order_relaxed);
+		}
+	}
+
+	// tells n threads to wake-up, if any is sleeping
+	void wake(uint64_t n) {
+		if (sleeping == 0)
+			return;
+
+		// tasks are pushed to the work-stealing, priority and ring
+		// backends without the mutex, holding it here makes sure that
+		// a thread about to sleep is already waiting on cv
+		std::unique_lock<std::mutex> unique_lock(mutex, std::defer_lock);
+		if (backend != Backend::CENTRAL)
+			unique_lock.lock();
+
+		if (n >= capacity)
+			cv.notify_all();
+		else
+			for (uint64_t i=0; i<n; ++i)
+				cv.notify_one();
+	}
+
+	// appends n tasks to the queue of the backend in use,
+	// make_task(i) builds the i-th one
+	template <typename Factory>
+	void push(Factory && make_task, uint64_t n) {
+
+		// tasks are timestamped for the enqueue-to-start latency
+		const uint64_t enqueued = collect_stats ? now_ns() : 0;
+
+		if (backend != Backend::CENTRAL) {
+			for (uint64_t i=0; i<n; ++i) {
+				Task task = make_task(i);
+				task.enqueued = enqueued;
+				if (backend == Backend::WORK_STEALING)
+					push_stealing(std::move(task));
+				else if (backend == Backend::PRIORITY)
+					push_priority(std::move(task), 0);
+				else
+					push_ring(std::move(task));
+			}
+			wake(n);
+			return;
+		}
+
+		{
+			// lock the scope
+			ThreadStats *stats = local_stats();
+			std::lock_guard<std::mutex>	lock_guard(mutex);
+			if (stats)
+				ThreadStats::add(stats->mutex_ns, now_ns()-enqueued);
+
+			// you cannot reuse pool after being stopped
+			if(stop_pool)
+				throw std::runtime_error("enqueue on stopped ThreadPool");
+
+			// append the tasks to the queue
+			for (uint64_t i=0; i<n; ++i) {
+				Task task = make_task(i);
+				task.enqueued = enqueued;
+				tasks.push(std::move(task));
+			}
+			queued += n;
+		}
+
+		wake(n);
+	}
+
+	// appends a task to the queue of the backend in use
+	void push(Task && task) {
+		push([&task] (uint64_t) -> Task { return std::move(task); }, 1);
+	}
+
+public:
+
+	// an index range whose chunks are claimed by the threads through an
+	// atomic cursor, see enqueue_range
+	class Range {
+
+		friend class ThreadPool;
+
+	private:
+
+		alignas(64) std::atomic<uint64_t> next;
+		alignas(64) std::atomic<uint64_t> remaining; // indices not done
+		std::atomic<bool> completed;
+		const uint64_t end;
+		const uint64_t grain;
+
+		// computes the indices in [chunk_begin, chunk_end)
+		virtual void run_chunk(uint64_t chunk_begin, uint64_t chunk_end) = 0;
+
+		// claims and computes chunks until the range is exhausted
+		void run() {
+			uint64_t chunk_begin;
+			while ((chunk_begin = next.fetch_add(grain)) < end) {
+				uint64_t chunk_end = std::min(chunk_begin+grain, end);
+				run_chunk(chunk_begin, chunk_end);
+				uint64_t size = chunk_end-chunk_begin;
+				if (remaining.fetch_sub(size) == size) {
+					completed = true;
+					completed.notify_all();
+				}
+			}
+		}
+
+	protected:
+		Range(uint64_t begin, uint64_t end_, uint64_t grain_) :
+			next(begin),
+			remaining(end_ > begin ? end_-begin : 0),
+			completed(end_ <= begin),
+			end(end_),
+			grain(std::max<uint64_t>(grain_, 1)) {}
+
+	public:
+		virtual ~Range() = default;
+
+		// blocks until all the indices have been computed
+		void wait() {
+			completed.wait(false);
+		}
+
+		bool done() const {
+			return completed;
+		}
+	};
+
+private:
+
+	template <typename Func>
+	class RangeOf : public Range {
+		Func func;
+
+		void run_chunk(uint64_t chunk_begin, uint64_t chunk_end) override {
+			for (uint64_t i=chunk_begin; i<chunk_end; ++i)
+				func(i);
+		}
+
+	public:
+		template <typename F>
+		RangeOf(uint64_t begin, uint64_t end, uint64_t grain, F && func_) :
+			Range(begin, end, grain),
+			func(std::forward<F>(func_)) {}
+	};
+
 public:
-	ThreadPool(uint64_t capacity_) :
+	ThreadPool(uint64_t capacity_, Backend backend_=Backend::CENTRAL) :
+		ThreadPool(capacity_, backend_, IdlePolicy()) {}
+
+	// the id-th thread is pinned to cpus_[id % cpus_.size()], with
+	// collect_stats_ the threads keep the counters returned by stats();
+	// the ring backend has ring_slots_ slots (rounded up to a power of two)
+	ThreadPool(uint64_t capacity_, Backend backend_, IdlePolicy idle_,
+		std::vector<int> cpus_={}, bool collect_stats_=false,
+		uint64_t ring_slots_=default_ring_slots) :
 		stop_pool(false), // pool is running
 		active_threads(0), // no work to be done
-		capacity(capacity_) { // remember size
-
-		// this function is executed by the threads
-		auto wait_loop = [this] ( ) -> void {
-
-			// wait forever
-			while (true) {
-
-				// this is a placeholder task
-				std::function<void(void)> task;
-
-				{
-					// lock this section for waiting
-					std::unique_lock<std::mutex>
-						unique_lock(mutex);
-
-					// actions must be performed on
-					// wake-up if (i) the thread pool
-					// has been stopped, or (ii) there
-					// are still tasks to be processed
-					auto predicate = [this] ( ) -> bool {
-						return (stop_pool) || !(tasks.empty());
-					};
-
-					// wait to be waken up on
-					// aforementioned conditions
-					cv.wait(unique_lock, predicate);
-
-					// exit if thread pool stopped
-					// and no tasks to be performed
-					if (stop_pool && tasks.empty())
-						return;
-
-					// else extract task from queue
-					task = std::move(tasks.front());
-					tasks.pop();
-					before_task_hook();
-				} // here we release the lock
-
-				// execute the task in parallel
-				task();
-
-				{
-					// adjust the thread counter
-					std::lock_guard<std::mutex>	lock_guard(mutex);
-					after_task_hook();
-				} // here we release the lock
+		capacity(capacity_), // remember size
+		backend(backend_),
+		idle(idle_),
+		cpus(std::move(cpus_)),
+		collect_stats(collect_stats_),
+		thread_stats(new ThreadStats[capacity_]) {
+
+		if (backend == Backend::RING)
+			ring = std::make_unique<MPMCRing<Task>>(ring_slots_);
+		else if (backend != Backend::CENTRAL) {
+			for (uint64_t id = 0; id < capacity; id++) {
+				workers.emplace_back(std::make_unique<Worker>());
+				workers.back()->seed = id+1;
 			}
-		};
+		}
 
 		// initially spawn capacity many threads
-		for (uint64_t id = 0; id < capacity; id++)
-			threads.emplace_back(wait_loop);
+		for (uint64_t id = 0; id < capacity; id++) {
+			if (backend == Backend::WORK_STEALING)
+				threads.emplace_back(&ThreadPool::stealing_loop, this, id);
+			else if (backend == Backend::PRIORITY)
+				threads.emplace_back(&ThreadPool::priority_loop, this, id);
+			else if (backend == Backend::RING)
+				threads.emplace_back(&ThreadPool::ring_loop, this, id);
+			else
+				threads.emplace_back(&ThreadPool::central_loop, this, id);
+		}
 	}
 
 	~ThreadPool() {
@@ -124,6 +823,33 @@ public:
 		for (auto& thread : threads)
 			thread.join();
 	}
+
+	// number of threads of the pool
+	uint32_t size() const {
+		return capacity;
+	}
+
+	// statistics of the threads so far (all zero if they are not
+	// collected); the times do not include the threads enqueueing
+	// from outside of the pool
+	Stats stats() const {
+		Stats snapshot;
+		snapshot.latency.assign(latency_buckets, 0);
+		uint64_t mutex_ns = 0, sleep_ns = 0;
+		for (uint32_t id=0; id<capacity; ++id) {
+			const ThreadStats &t = thread_stats[id];
+			snapshot.tasks.push_back(t.tasks.load(std::memory_order_relaxed));
+			snapshot.queue_high_water = std::max(snapshot.queue_high_water,
+				t.queue_high_water.load(std::memory_order_relaxed));
+			mutex_ns += t.mutex_ns.load(std::memory_order_relaxed);
+			sleep_ns += t.sleep_ns.load(std::memory_order_relaxed);
+			for (uint32_t b=0; b<latency_buckets; ++b)
+				snapshot.latency[b] += t.latency[b].load(std::memory_order_relaxed);
+		}
+		snapshot.mutex_time = mutex_ns/1e9;
+		snapshot.sleep_time = sleep_ns/1e9;
+		return snapshot;
+	}
 	
 	template <typename Func, typename ... Args,
 			  typename Rtrn=typename std::result_of<Func(Args...)>::type>
@@ -134,32 +860,116 @@ public:
 		auto task = make_task(func, args...);
 		auto future = task.get_future();
 		auto task_ptr = std::make_shared<decltype(task)>(std::move(task));
-		
-		{
-			// lock the scope
-			std::lock_guard<std::mutex>	lock_guard(mutex);
 
-			// you cannot reuse pool after being stopped
-			if(stop_pool)
-				throw std::runtime_error("enqueue on stopped ThreadPool");
+		// wrap the task in a generic void
+		// function void -> void
+		auto payload = [task_ptr] ( ) -> void {
+			// basically call task()
+			task_ptr->operator()();
+		};
+
+		push(Task(std::move(payload)));
+
+		return future;
+	}
 
-			// wrap the task in a generic void
-			// function void -> void
-			auto payload = [task_ptr] ( ) -> void {
-				// basically call task()
-				task_ptr->operator()();
-			};
+	// fire-and-forget version of enqueue: no future is returned and, if
+	// func and args fit in Task::inline_size bytes, nothing is allocated
+	// (exceptions thrown by func terminate the program)
+	template <typename Func, typename ... Args>
+	void submit(Func && func, Args && ... args) {
+		push(Task([func=std::forward<Func>(func),
+				   ...args=std::forward<Args>(args)] ( ) mutable -> void {
+			std::invoke(func, args...);
+		}));
+	}
 
-			// append the task to the queue
-			tasks.emplace(payload);
+	// submit with a priority: with the priority backend the threads take
+	// the task with the highest priority among the ones enqueued (the
+	// tasks enqueued in other ways have priority 0), the other backends
+	// ignore it
+	template <typename Func, typename ... Args>
+	void submit_priority(uint64_t priority, Func && func, Args && ... args) {
+		Task task([func=std::forward<Func>(func),
+				   ...args=std::forward<Args>(args)] ( ) mutable -> void {
+			std::invoke(func, args...);
+		});
+		if (backend != Backend::PRIORITY) {
+			push(std::move(task));
+			return;
 		}
+		task.enqueued = collect_stats ? now_ns() : 0;
+		push_priority(std::move(task), priority);
+		wake(1);
+	}
 
-		// tell one thread to wake-up
-		cv.notify_one();
+	// resumes the suspended coroutine handle as a task of the pool
+	void resume(std::coroutine_handle<> handle) {
+		submit([handle] ( ) -> void { handle.resume(); });
+	}
 
-		return future;
+	// awaitable moving a coroutine to the pool: after co_await TP.schedule()
+	// the coroutine runs as a task on one of its threads
+	class ScheduleAwaiter {
+
+	private:
+
+		ThreadPool &pool;
+
+	public:
+		explicit ScheduleAwaiter(ThreadPool &pool_) : pool(pool_) {}
+
+		bool await_ready() const {
+			return false;
+		}
+
+		void await_suspend(std::coroutine_handle<> handle) {
+			pool.resume(handle);
+		}
+
+		void await_resume() const {}
+	};
+
+	ScheduleAwaiter schedule() {
+		return ScheduleAwaiter(*this);
+	}
+
+	// whether the calling thread is one of the pool
+	bool in_pool() const {
+		return local_pool == this;
+	}
+
+	// calls func(i) for each i in [begin, end), in chunks of grain indices:
+	// the range is published under a single lock and as many threads as
+	// there are chunks (at most all of them) are woken up to claim them
+	template <typename Func>
+	auto enqueue_range(uint64_t begin, uint64_t end, uint64_t grain,
+		Func && func) -> std::shared_ptr<Range> {
+
+		auto range = std::make_shared<RangeOf<std::decay_t<Func>>>(
+			begin, end, grain, std::forward<Func>(func));
+		if (range->done())
+			return range;
+
+		uint64_t chunks = (end-begin+range->grain-1)/range->grain;
+		push([&range] (uint64_t) -> Task {
+			return Task([range] ( ) -> void { range->run(); });
+		}, std::min<uint64_t>(chunks, capacity));
+
+		return range;
+	}
+
+	// blocking version of enqueue_range, a thread of the pool calling
+	// it also claims chunks instead of just waiting
+	template <typename Func>
+	void parallel_for(uint64_t begin, uint64_t end, uint64_t grain,
+		Func && func) {
+
+		auto range = enqueue_range(begin, end, grain, std::forward<Func>(func));
+		if (local_pool == this)
+			range->run();
+		range->wait();
 	}
 };
 
 #endif
-
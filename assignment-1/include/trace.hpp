@@ -0,0 +1,209 @@
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#include <cstdint>
+#include <cstdio>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <algorithm>
+#include <spin.hpp>
+
+// Tracing of the wavefront algorithms and of the thread pool, enabled at
+// compile time with -DTRACE (make TRACE=1). Each thread records
+// (start, end, index, diagonal) events in its own ring buffer, timed with
+// the time stamp counter, without locks nor allocations after the first
+// event; the events are dumped as Chrome trace JSON (chrome://tracing or
+// ui.perfetto.dev) and summed up per thread (the sums are kept as the
+// events are recorded, they include the ones dropped from the buffers).
+// With TRACE 0 all the functions are empty and TraceScope is an empty
+// object, the calls compile to nothing.
+
+#ifndef TRACE
+	#define TRACE 0
+#endif
+
+#ifndef TRACE_EVENTS
+	#define TRACE_EVENTS (1 << 16) // events kept per thread (power of two)
+#endif
+
+enum class TraceKind : uint8_t {
+	ELEMENT, // computation of an element (or a tile)
+	BARRIER, // wait on a barrier or on a neighbour
+	QUEUE    // pool thread looking for (or waiting for) a task
+};
+
+struct TraceEvent {
+	uint64_t start;
+	uint64_t end;
+	uint64_t index;
+	uint32_t diagonal;
+	TraceKind kind;
+};
+
+// cheap timestamp: time stamp counter if available, else steady_clock ns
+inline uint64_t trace_clock() {
+#if !TRACE
+	return 0;
+#elif defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#else
+	return std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+}
+
+class Tracer {
+
+private:
+
+	struct Buffer {
+		std::string name;
+		std::unique_ptr<TraceEvent[]> events;
+		uint64_t count = 0; // events recorded, the last TRACE_EVENTS are kept
+		uint64_t totals[3] = {0, 0, 0}; // ticks of all the events, by kind
+
+		Buffer() : events(new TraceEvent[TRACE_EVENTS]) {}
+	};
+
+	std::mutex mutex; // only taken by the first event of a thread
+	std::vector<std::unique_ptr<Buffer>> buffers;
+
+	const uint64_t clock_origin; // timestamp of the first event
+
+	inline static thread_local Buffer *local = nullptr;
+
+	Tracer() : clock_origin(trace_clock()) {}
+
+	Buffer& buffer() {
+		if (!local) {
+			std::lock_guard<std::mutex> lock_guard(mutex);
+			buffers.emplace_back(std::make_unique<Buffer>());
+			local = buffers.back().get();
+			local->name = "thread " + std::to_string(buffers.size()-1);
+		}
+		return *local;
+	}
+
+	// timestamp ticks per microsecond, from the calibration of spin_for
+	static double ticks_per_us() {
+#if defined(__x86_64__) || defined(__i386__)
+		return tsc_calibration().ticks_per_ns*1000;
+#else
+		return 1000; // steady_clock nanoseconds
+#endif
+	}
+
+public:
+	static Tracer& instance() {
+		static Tracer tracer;
+		return tracer;
+	}
+
+	void record(TraceKind kind, uint64_t start, uint64_t end,
+		uint64_t index, uint64_t diagonal) {
+		Buffer &b = buffer();
+		b.events[b.count & (TRACE_EVENTS-1)] =
+			{start, end, index, static_cast<uint32_t>(diagonal), kind};
+		b.count++;
+		b.totals[static_cast<int>(kind)] += end-start;
+	}
+
+	void name_thread(const std::string &name) {
+		buffer().name = name;
+	}
+
+	// writes the events of all the threads as Chrome trace JSON, to be
+	// called when the traced threads are not running
+	void dump(const std::string &file_name) {
+		std::lock_guard<std::mutex> lock_guard(mutex);
+		const double scale = ticks_per_us();
+		static const char *names[] = {"element", "barrier", "queue"};
+
+		std::ofstream file(file_name);
+		file << "{\"traceEvents\":[\n";
+		bool first = true;
+		for (uint64_t t=0; t<buffers.size(); ++t) {
+			const Buffer &b = *buffers[t];
+			file << (first ? "" : ",\n") << "{\"name\":\"thread_name\","
+				<< "\"ph\":\"M\",\"pid\":0,\"tid\":" << t
+				<< ",\"args\":{\"name\":\"" << b.name << "\"}}";
+			first = false;
+			uint64_t kept = std::min<uint64_t>(b.count, TRACE_EVENTS);
+			for (uint64_t e=b.count-kept; e<b.count; ++e) {
+				const TraceEvent &event = b.events[e & (TRACE_EVENTS-1)];
+				const char *name = names[static_cast<int>(event.kind)];
+				file << ",\n{\"name\":\"" << name << "\",\"cat\":\"" << name
+					<< "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << t
+					<< ",\"ts\":" << (event.start-clock_origin)/scale
+					<< ",\"dur\":" << (event.end-event.start)/scale
+					<< ",\"args\":{\"index\":" << event.index
+					<< ",\"diagonal\":" << event.diagonal << "}}";
+			}
+		}
+		file << "\n]}\n";
+	}
+
+	// prints the busy, barrier wait and queue wait time of each thread,
+	// over all its events (the oldest ones may be missing from the dump)
+	void summary() {
+		std::lock_guard<std::mutex> lock_guard(mutex);
+		const double scale = ticks_per_us();
+		std::printf("%-12s %12s %12s %12s %10s\n", "thread", "busy (ms)",
+			"barrier (ms)", "queue (ms)", "events");
+		for (const auto &b : buffers) {
+			std::printf("%-12s %12.3f %12.3f %12.3f %10lu%s\n", b->name.c_str(),
+				b->totals[0]/scale/1000, b->totals[1]/scale/1000,
+				b->totals[2]/scale/1000, b->count,
+				(b->count > TRACE_EVENTS) ? " (oldest not dumped)" : "");
+		}
+	}
+};
+
+// records an event of the calling thread that started at start and ends now
+inline void trace_event(TraceKind kind, uint64_t start, uint64_t index=0,
+	uint64_t diagonal=0) {
+	if constexpr (TRACE)
+		Tracer::instance().record(kind, start, trace_clock(), index, diagonal);
+}
+
+// name of the calling thread in the trace
+inline void trace_thread_name(const std::string &name) {
+	if constexpr (TRACE)
+		Tracer::instance().name_thread(name);
+}
+
+// records an event lasting as long as the scope
+class TraceScope {
+
+private:
+
+#if TRACE
+	TraceKind kind;
+	uint64_t start;
+	uint64_t index;
+	uint64_t diagonal;
+#endif
+
+public:
+#if TRACE
+	TraceScope(TraceKind kind_, uint64_t index_=0, uint64_t diagonal_=0) :
+		kind(kind_),
+		start(trace_clock()),
+		index(index_),
+		diagonal(diagonal_) {}
+
+	~TraceScope() {
+		trace_event(kind, start, index, diagonal);
+	}
+#else
+	TraceScope(TraceKind, uint64_t=0, uint64_t=0) {}
+#endif
+
+	TraceScope(const TraceScope&) = delete;
+	TraceScope& operator=(const TraceScope&) = delete;
+};
+
+#endif
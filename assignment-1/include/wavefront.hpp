@@ -0,0 +1,188 @@
+#ifndef WAVEFRONT_HPP
+#define WAVEFRONT_HPP
+
+#include <cstdint>
+#include <vector>
+#include <thread>
+#include <algorithm>
+#include <threadPool.hpp>
+#include <barrier.hpp>
+#include <affinity.hpp>
+#include <executor.hpp>
+
+// Generic wavefront: the elements are grouped into fronts, the elements of
+// a front only depend on the ones of the previous fronts and can be
+// computed in parallel. wavefront(kernel, scheduler, layout) calls
+// kernel(row, col) on every element of every front of the layout, with the
+// order given by the scheduler. Everything is resolved at compile time:
+// the kernel is inlined in the loops over the elements, there are no
+// virtual calls nor std::function per element.
+
+// coordinates of an element
+struct Cell {
+	uint64_t row;
+	uint64_t col;
+};
+
+// Layouts: the number of fronts, the number of elements of each front and
+// the coordinates of the e-th element of the d-th front.
+
+// upper triangle of an NxN matrix by upper diagonals, (i,j) depending on
+// (i,j-1) and (i+1,j): the d-th front is the diagonal first+d
+class UpperTriangle {
+
+private:
+
+	uint64_t N;
+	uint64_t first;
+
+public:
+	explicit UpperTriangle(uint64_t N_, uint64_t first_=0) :
+		N(N_),
+		first(std::min(first_, N_)) {}
+
+	uint64_t fronts() const {
+		return N-first;
+	}
+
+	uint64_t size(const uint64_t &d) const {
+		return N-first-d;
+	}
+
+	Cell cell(const uint64_t &d, const uint64_t &e) const {
+		return {e, e+first+d};
+	}
+};
+
+// rows x cols table by anti-diagonals, (i,j) depending on (i-1,j),
+// (i,j-1) and (i-1,j-1) as in the dynamic programming on two sequences
+// (edit distance, Smith-Waterman): the d-th front is made of the elements
+// with i+j=d, by increasing row
+class AntiDiagonals {
+
+private:
+
+	uint64_t rows;
+	uint64_t cols;
+
+	uint64_t first_row(const uint64_t &d) const {
+		return (d >= cols) ? d-cols+1 : 0;
+	}
+
+public:
+	AntiDiagonals(uint64_t rows_, uint64_t cols_) :
+		rows(rows_),
+		cols(cols_) {}
+
+	uint64_t fronts() const {
+		return (rows > 0 && cols > 0) ? rows+cols-1 : 0;
+	}
+
+	uint64_t size(const uint64_t &d) const {
+		return std::min(d, rows-1)-first_row(d)+1;
+	}
+
+	Cell cell(const uint64_t &d, const uint64_t &e) const {
+		uint64_t row = first_row(d)+e;
+		return {row, d-row};
+	}
+};
+
+// Schedulers: run(kernel, layout) computes all the fronts in order.
+
+// the calling thread computes the elements one front after the other
+struct SequentialScheduler {
+
+	template <typename Kernel, typename Layout>
+	void run(Kernel &kernel, const Layout &layout) const {
+		for (uint64_t d=0; d<layout.fronts(); ++d) { // for each front
+			const uint64_t size = layout.size(d);
+			for (uint64_t e=0; e<size; ++e) { // for each elem. in the front
+				Cell c = layout.cell(d, e);
+				kernel(c.row, c.col);
+			}
+		}
+	}
+};
+
+// T threads (placed on cpus, if not empty) compute a contiguous block of
+// each front and wait for each other on a barrier (see barrier.hpp)
+// before the next one; the threads are either created for the run or
+// the workers of an executor
+template <typename Barrier=CentralBarrier>
+struct StaticScheduler {
+
+	Barrier &bar;
+	uint32_t T;
+	std::vector<int> cpus;
+	Executor *ex = nullptr;
+
+	StaticScheduler(Barrier &bar_, uint32_t T_, std::vector<int> cpus_={}) :
+		bar(bar_),
+		T(T_),
+		cpus(std::move(cpus_)) {}
+
+	StaticScheduler(Barrier &bar_, Executor &ex_) :
+		bar(bar_),
+		T(ex_.size()),
+		ex(&ex_) {}
+
+	template <typename Kernel, typename Layout>
+	void run(Kernel &kernel, const Layout &layout) {
+		auto static_task = [&] (const uint64_t id) -> void {
+			pin_thread(cpus, id);
+			for (uint64_t d=0; d<layout.fronts(); ++d) { // for each front
+				const uint64_t size = layout.size(d);
+				for (uint64_t e=id*size/T; e<(id+1)*size/T; ++e) { // own block
+					Cell c = layout.cell(d, e);
+					kernel(c.row, c.col);
+				}
+				bar.arrive_and_wait(id);
+			}
+		};
+
+		if (ex) {
+			ex->run(static_task);
+			return;
+		}
+
+		std::vector<std::thread> threads;
+		for (uint64_t id=0; id<T; id++)
+			threads.emplace_back(static_task, id);
+
+		for (auto &thread : threads)
+			thread.join();
+	}
+};
+
+// the threads of a pool claim chunks of grain elements of the current
+// front (0 for chunks of 1/(4T) of the front), see ThreadPool::parallel_for
+struct DynamicScheduler {
+
+	ThreadPool &pool;
+	uint64_t grain;
+
+	explicit DynamicScheduler(ThreadPool &pool_, uint64_t grain_=0) :
+		pool(pool_),
+		grain(grain_) {}
+
+	template <typename Kernel, typename Layout>
+	void run(Kernel &kernel, const Layout &layout) {
+		const uint64_t T = std::max<uint64_t>(pool.size(), 1);
+		for (uint64_t d=0; d<layout.fronts(); ++d) { // for each front
+			const uint64_t size = layout.size(d);
+			uint64_t chunk = grain ? grain : std::max<uint64_t>(1, size/(4*T));
+			pool.parallel_for(0, size, chunk, [&, d](uint64_t e) {
+				Cell c = layout.cell(d, e);
+				kernel(c.row, c.col);
+			});
+		}
+	}
+};
+
+template <typename Kernel, typename Scheduler, typename Layout>
+void wavefront(Kernel &&kernel, Scheduler &&scheduler, const Layout &layout) {
+	scheduler.run(kernel, layout);
+}
+
+#endif
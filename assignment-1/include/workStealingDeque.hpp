@@ -0,0 +1,129 @@
+#ifndef WORKSTEALINGDEQUE_HPP
+#define WORKSTEALINGDEQUE_HPP
+
+#include <cstdint>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+// Chase-Lev work-stealing deque (memory orderings as in Le et al., "Correct
+// and Efficient Work-Stealing for Weak Memory Models", PPoPP'13).
+// The owner thread pushes and pops at the bottom without taking any lock,
+// other threads steal from the top with a single CAS.
+// Items must be trivially copyable (the pool stores pointers to tasks).
+template <typename Item>
+class WorkStealingDeque {
+
+private:
+
+	// circular array, replaced by a twice as large one when full
+	struct Array {
+		const int64_t capacity;
+		const int64_t mask;
+		std::unique_ptr<std::atomic<Item>[]> slots;
+
+		explicit Array(int64_t capacity_) :
+			capacity(capacity_),
+			mask(capacity_-1),
+			slots(new std::atomic<Item>[capacity_]) {}
+
+		Item get(int64_t i) const {
+			return slots[i & mask].load(std::memory_order_relaxed);
+		}
+
+		void put(int64_t i, Item item) {
+			slots[i & mask].store(item, std::memory_order_relaxed);
+		}
+	};
+
+	// top and bottom are kept on different cache lines
+	// since they are written by different threads
+	alignas(64) std::atomic<int64_t> top;
+	alignas(64) std::atomic<int64_t> bottom;
+	alignas(64) std::atomic<Array*> array;
+
+	// arrays replaced by a grow may still be read by a thief, hence
+	// they are released only when the deque is destroyed (owner only)
+	std::vector<std::unique_ptr<Array>> arrays;
+
+	Array* grow(Array *old, int64_t b, int64_t t) {
+		auto bigger = std::make_unique<Array>(2*old->capacity);
+		for (int64_t i=t; i<b; ++i)
+			bigger->put(i, old->get(i));
+		arrays.push_back(std::move(bigger));
+		return arrays.back().get();
+	}
+
+public:
+	explicit WorkStealingDeque(int64_t capacity=1024) : top(0), bottom(0) {
+		// the capacity must be a power of two
+		int64_t c = 1;
+		while (c < capacity) c <<= 1;
+		arrays.push_back(std::make_unique<Array>(c));
+		array.store(arrays.back().get(), std::memory_order_relaxed);
+	}
+
+	WorkStealingDeque(const WorkStealingDeque&) = delete;
+	WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+	// owner only
+	void push(Item item) {
+		int64_t b = bottom.load(std::memory_order_relaxed);
+		int64_t t = top.load(std::memory_order_acquire);
+		Array *a = array.load(std::memory_order_relaxed);
+		if (b-t > a->capacity-1) {
+			a = grow(a, b, t);
+			array.store(a, std::memory_order_release);
+		}
+		a->put(b, item);
+		std::atomic_thread_fence(std::memory_order_release);
+		bottom.store(b+1, std::memory_order_relaxed);
+	}
+
+	// owner only, returns false if the deque is empty
+	bool pop(Item &item) {
+		int64_t b = bottom.load(std::memory_order_relaxed)-1;
+		Array *a = array.load(std::memory_order_relaxed);
+		bottom.store(b, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		int64_t t = top.load(std::memory_order_relaxed);
+
+		if (t > b) { // empty
+			bottom.store(b+1, std::memory_order_relaxed);
+			return false;
+		}
+
+		item = a->get(b);
+		if (t == b) { // last item, race against thieves
+			bool won = top.compare_exchange_strong(t, t+1,
+				std::memory_order_seq_cst, std::memory_order_relaxed);
+			bottom.store(b+1, std::memory_order_relaxed);
+			return won;
+		}
+		return true;
+	}
+
+	// any thread, returns false if the deque is empty or the race is lost
+	bool steal(Item &item) {
+		int64_t t = top.load(std::memory_order_acquire);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		int64_t b = bottom.load(std::memory_order_acquire);
+
+		if (t >= b)
+			return false;
+
+		Array *a = array.load(std::memory_order_acquire);
+		item = a->get(t);
+		return top.compare_exchange_strong(t, t+1,
+			std::memory_order_seq_cst, std::memory_order_relaxed);
+	}
+
+	// approximate, any thread
+	bool empty() const {
+		int64_t b = bottom.load(std::memory_order_relaxed);
+		int64_t t = top.load(std::memory_order_relaxed);
+		return b <= t;
+	}
+};
+
+#endif
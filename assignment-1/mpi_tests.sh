@@ -0,0 +1,43 @@
+#!/bin/bash
+
+DEFAULT_N=512
+DEFAULT_MIN=0
+DEFAULT_MAX=1000
+NUM_PROCESSES=4
+LOGFILE="wavefront_mpi_log.csv"
+
+# parsing command line arguments
+# (both optional, first one is the number of processes, second one is the log
+# file)
+if [ $# -gt 0 ]; then
+    NUM_PROCESSES=$1
+    if ! [[ $NUM_PROCESSES =~ ^[0-9]+$ ]] || [ $NUM_PROCESSES -lt 1 ]; then
+        echo "Please provide a positive number for the first argument."
+        exit 1
+    fi
+    if [ $# -gt 1 ]; then
+        LOGFILE=$2
+    fi
+fi
+
+# empty the log file
+truncate -s 0 $LOGFILE
+
+# each run checks its result against the sequential one and fails otherwise
+######################## TESTING STRONG SCALABILITY ############################
+echo "Testing strong scalability (P = 1..$NUM_PROCESSES)"
+for p in $(seq 1 $NUM_PROCESSES); do
+    mpirun -n $p ./wavefront_mpi -N $DEFAULT_N -m $DEFAULT_MIN \
+        -M $DEFAULT_MAX -l $LOGFILE || exit 1
+done
+
+##################### TESTING BLOCK AND TILE SIZES #############################
+# block-row (rows 0) against block-cyclic distributions, and the size of the
+# messages of the pipeline
+echo "Testing block and tile sizes (P = $NUM_PROCESSES)"
+for r in 0 64 16; do
+    for c in 8 32 128; do
+        mpirun -n $NUM_PROCESSES ./wavefront_mpi -N $DEFAULT_N \
+            -m $DEFAULT_MIN -M $DEFAULT_MAX -r $r -c $c -l $LOGFILE || exit 1
+    done
+done
@@ -0,0 +1,40 @@
+#!/bin/bash
+
+REPETITIONS=10
+DEFAULT_N=512
+DEFAULT_MIN=0
+DEFAULT_MAX=10
+YIELDS=100
+NUM_CORES=40
+LOGFILE="wavefront_spin_log.csv"
+
+# parsing command line arguments
+# (both optional, first one is the number of cores, second one is the log file)
+if [ $# -gt 0 ]; then
+    NUM_CORES=$1
+    if ! [[ $NUM_CORES =~ ^[0-9]+$ ]] ||
+        [ $NUM_CORES -lt 1 ] ||
+        [ $NUM_CORES -gt 60 ]; then
+        echo "Please provide a number in [1, 60] for the first argument."
+        exit 1
+    fi
+    if [ $# -gt 1 ]; then
+        LOGFILE=$2
+    fi
+fi
+
+# empty the log file (the detail log of wavefront, as it has the spins)
+truncate -s 0 $LOGFILE
+
+######################## TESTING THE SPIN BUDGET ###############################
+echo "Testing the spin budget of the idle pool threads"
+for queue in central stealing ring; do
+    for spins in 0 10 100 1000 10000 100000; do
+        for yields in 0 $YIELDS; do
+            for rep in $(seq 1 $REPETITIONS); do
+                echo "[$rep/$REPETITIONS] T = $NUM_CORES, N = $DEFAULT_N, min = $DEFAULT_MIN, max = $DEFAULT_MAX, queue = $queue, spins = $spins, yields = $yields"
+                ./wavefront -N $DEFAULT_N -T $NUM_CORES -m $DEFAULT_MIN -M $DEFAULT_MAX -q $queue -S $spins -Y $yields -A dynamic,dataflow,tiled -l /dev/null -D $LOGFILE
+            done
+        done
+    done
+done
@@ -8,6 +8,8 @@ DEFAULT_MIN=0
 DEFAULT_MAX=1000
 NUM_CORES=40
 LOGFILE="wavefront_log.csv"
+DETAIL_LOGFILE="wavefront_detail_log.csv"
+QUEUE_LOGFILE="wavefront_queue_log.csv"
 
 # parsing command line arguments
 # (both optional, first one is the number of cores, second one is the log file)
@@ -31,8 +33,8 @@ for i in $(seq 1 $REPETITIONS); do
     ./wavefront -s -l wavefront_seq_log.csv
 done
 
-# empty the log file
-truncate -s 0 $LOGFILE
+# empty the log files
+truncate -s 0 $LOGFILE $DETAIL_LOGFILE $QUEUE_LOGFILE
 
 ######################## TESTING STRONG SCALABILITY ############################
 echo "Testing strong scalability"
@@ -40,7 +42,7 @@ for t in $(seq 0 $THREADS_STEP $NUM_CORES); do
     thr=$((t == 0 ? t + 1 : t))
     for rep in $(seq 1 $REPETITIONS); do
         echo "[$rep/$REPETITIONS] T = $thr, N = $DEFAULT_N, min = $DEFAULT_MIN, max = $DEFAULT_MAX"
-        ./wavefront -N $DEFAULT_N -T $thr -m $DEFAULT_MIN -M $DEFAULT_MAX -l $LOGFILE
+        ./wavefront -N $DEFAULT_N -T $thr -m $DEFAULT_MIN -M $DEFAULT_MAX -l $LOGFILE -D $DETAIL_LOGFILE
     done
 done
 
@@ -51,7 +53,7 @@ for t in $(seq 4 $THREADS_STEP $NUM_CORES); do
     min=$((max-SIZE_MIN_MAX_WINDOWS))
     for rep in $(seq 1 $REPETITIONS); do
         echo "[$rep/$REPETITIONS] T = $t, N = $DEFAULT_N, min = $min, max = $max"
-        ./wavefront -N $DEFAULT_N -T $t -m $min -M $max -l $LOGFILE
+        ./wavefront -N $DEFAULT_N -T $t -m $min -M $max -l $LOGFILE -D $DETAIL_LOGFILE
     done
 done
 
@@ -60,7 +62,7 @@ echo "Testing with unbalanced workloads"
 for max in 100 2000; do
     for rep in $(seq 1 $REPETITIONS); do
         echo "[$rep/$REPETITIONS] T = $NUM_CORES, N = $DEFAULT_N, min = 0, max = $max"
-        ./wavefront -N $DEFAULT_N -T $NUM_CORES -m 0 -M $max -l $LOGFILE
+        ./wavefront -N $DEFAULT_N -T $NUM_CORES -m 0 -M $max -l $LOGFILE -D $DETAIL_LOGFILE
     done
 done
 
@@ -69,6 +71,15 @@ echo "Testing with balanced workloads"
 for m in 0 500; do
     for rep in $(seq 1 $REPETITIONS); do
         echo "[$rep/$REPETITIONS] T = $NUM_CORES, N = $DEFAULT_N, min = $m, max = $m"
-        ./wavefront -N $DEFAULT_N -T $NUM_CORES -m $m -M $m -l $LOGFILE
+        ./wavefront -N $DEFAULT_N -T $NUM_CORES -m $m -M $m -l $LOGFILE -D $DETAIL_LOGFILE
     done
-done
\ No newline at end of file
+done
+
+######################## TESTING THE POOL BACKENDS #############################
+echo "Testing the backends of the thread pool"
+for queue in central stealing priority ring; do
+    for rep in $(seq 1 $REPETITIONS); do
+        echo "[$rep/$REPETITIONS] T = $NUM_CORES, N = $DEFAULT_N, min = $DEFAULT_MIN, max = $DEFAULT_MAX, queue = $queue"
+        ./wavefront -N $DEFAULT_N -T $NUM_CORES -m $DEFAULT_MIN -M $DEFAULT_MAX -q $queue -A dynamic,dataflow,tiled -l $QUEUE_LOGFILE -D $DETAIL_LOGFILE
+    done
+done
@@ -0,0 +1,344 @@
+#include <iostream>
+#include <unistd.h>
+#include <vector>
+#include <string>
+#include <random>
+#include <latch>
+#include <atomic>
+#include <cmath>
+#include <threadPool.hpp>
+#include <completionEvent.hpp>
+#include <packedMatrix.hpp>
+#include <fstream>
+
+#define DEFAULT_LOG_FILE "threadPool_bench_log.csv" // default log file name
+#define DEFAULT_n 100000 // default number of tasks
+#define DEFAULT_T 2 // default number of threads
+#define DEFAULT_m 0 // default minimum time (in microseconds)
+#define DEFAULT_M 10 // default maximum time (in microseconds)
+#define DEFAULT_RING_SLOTS 4096 // default slots of the ring backend
+
+#define TIMERSTART(label)\
+	std::chrono::time_point<std::chrono::system_clock> a##label, b##label;\
+	a##label = std::chrono::system_clock::now();
+
+#define TIMERSTOP(label, time_elapsed)\
+	b##label = std::chrono::system_clock::now();\
+	std::chrono::duration<double> delta##label = b##label-a##label;\
+	time_elapsed = delta##label.count();
+
+void work(std::chrono::nanoseconds w) {
+	spin_for(w);
+}
+
+const char* backend_name(ThreadPool::Backend backend) {
+	switch (backend) {
+		case ThreadPool::Backend::CENTRAL: return "central";
+		case ThreadPool::Backend::WORK_STEALING: return "stealing";
+		case ThreadPool::Backend::PRIORITY: return "priority";
+		case ThreadPool::Backend::RING: return "ring";
+	}
+	return "";
+}
+
+// how the tasks are handed to the pool: enqueue (with a future), submit
+// or as coroutines resumed on the pool
+enum class Api {ENQUEUE, SUBMIT, COROUTINE};
+
+const char* api_name(Api api) {
+	switch (api) {
+		case Api::ENQUEUE: return "enqueue";
+		case Api::SUBMIT: return "submit";
+		case Api::COROUTINE: return "coroutine";
+	}
+	return "";
+}
+
+// a task of the external pattern as a coroutine
+Job external_job(ThreadPool &TP, int cost, std::latch &done) {
+	co_await TP.schedule();
+	work(std::chrono::microseconds(cost));
+	done.count_down();
+}
+
+// the main thread enqueues all the tasks (producer-consumers)
+double bench_external(
+	ThreadPool::Backend backend,
+	const Api api,
+	const std::vector<int> &costs,
+	const uint32_t T,
+	const bool collect_stats,
+	const uint64_t ring_slots,
+	ThreadPool::Stats &stats
+	) {
+
+	std::latch done(costs.size());
+	auto task = [&] (int cost) {
+		work(std::chrono::microseconds(cost));
+		done.count_down();
+	};
+
+	ThreadPool TP(T, backend, ThreadPool::IdlePolicy(), {}, collect_stats,
+		ring_slots);
+	double time;
+	TIMERSTART(external);
+	for (const int &cost : costs) {
+		if (api == Api::SUBMIT)
+			TP.submit(task, cost);
+		else if (api == Api::ENQUEUE)
+			TP.enqueue(task, cost);
+		else
+			external_job(TP, cost, done);
+	}
+	done.wait();
+	TIMERSTOP(external, time);
+	stats = TP.stats();
+	return time;
+}
+
+// a node of the spawn pattern as a coroutine, starting its children
+// (each one moves to the pool at once)
+Job spawn_job(ThreadPool &TP, uint64_t i, const std::vector<int> &costs,
+	std::latch &done) {
+	co_await TP.schedule();
+	for (uint64_t child=2*i+1; child<=2*i+2; ++child)
+		if (child < costs.size())
+			spawn_job(TP, child, costs, done);
+	work(std::chrono::microseconds(costs[i]));
+	done.count_down();
+}
+
+// tasks are enqueued by the tasks themselves, as a binary tree
+double bench_spawn(
+	ThreadPool::Backend backend,
+	const Api api,
+	const std::vector<int> &costs,
+	const uint32_t T,
+	const bool collect_stats,
+	const uint64_t ring_slots,
+	ThreadPool::Stats &stats
+	) {
+
+	std::latch done(costs.size());
+
+	// declared before the pool, the threads may still
+	// be running it when the latch is released
+	std::function<void(uint64_t)> task;
+	ThreadPool TP(T, backend, ThreadPool::IdlePolicy(), {}, collect_stats,
+		ring_slots);
+
+	// the node i of the tree enqueues the nodes 2i+1 and 2i+2
+	task = [&] (uint64_t i) {
+		for (uint64_t child=2*i+1; child<=2*i+2; ++child)
+			if (child < costs.size()) {
+				if (api == Api::SUBMIT)
+					TP.submit(std::ref(task), child);
+				else
+					TP.enqueue(task, child);
+			}
+		work(std::chrono::microseconds(costs[i]));
+		done.count_down();
+	};
+
+	double time;
+	TIMERSTART(spawn);
+	if (api == Api::COROUTINE)
+		spawn_job(TP, 0, costs, done);
+	else
+		TP.submit(std::ref(task), 0);
+	done.wait();
+	TIMERSTOP(spawn, time);
+	stats = TP.stats();
+	return time;
+}
+
+// an element of the dataflow pattern as a coroutine, see
+// wavefront_parallel_coroutine
+Job dataflow_job(ThreadPool &TP, uint64_t k, uint64_t i,
+	const PackedMatrix<int> &costs, PackedMatrix<CompletionEvent> &events,
+	std::latch &done) {
+	if (k == 0)
+		co_await TP.schedule();
+	else
+		co_await when_all(TP, events(k-1,i), events(k-1,i+1));
+	work(std::chrono::microseconds(costs(k,i)));
+	events(k,i).set();
+	done.count_down();
+}
+
+// the tasks are the elements of a wavefront on the largest NxN upper
+// triangle with at most as many elements as costs, each one started when
+// its two predecessors are done, as in the dataflow algorithm of
+// wavefront (enqueue and submit) or in the coroutine one; returns the
+// number of elements
+uint64_t bench_dataflow(
+	ThreadPool::Backend backend,
+	const Api api,
+	const std::vector<int> &costs,
+	const uint32_t T,
+	const bool collect_stats,
+	const uint64_t ring_slots,
+	ThreadPool::Stats &stats,
+	double &time
+	) {
+
+	const uint64_t N = (std::sqrt(8.0*costs.size()+1)-1)/2;
+	PackedMatrix<int> M(N);
+	std::copy(costs.begin(), costs.begin()+M.size(), M.diagonal(0));
+
+	PackedMatrix<std::atomic<uint8_t>> deps(N);
+	for (uint64_t k=1; k<N; ++k)
+		for (uint64_t i=0; i<(N-k); ++i)
+			deps(k,i).store(2, std::memory_order_relaxed);
+	PackedMatrix<CompletionEvent> events(N);
+	std::latch done(M.size());
+
+	std::function<void(uint64_t, uint64_t)> task;
+	ThreadPool TP(T, backend, ThreadPool::IdlePolicy(), {}, collect_stats,
+		ring_slots);
+
+	auto start = [&] (uint64_t i, uint64_t k) {
+		if (api == Api::SUBMIT)
+			TP.submit(std::ref(task), i, k);
+		else
+			TP.enqueue(task, i, k);
+	};
+	task = [&] (uint64_t i, uint64_t k) {
+		work(std::chrono::microseconds(M(k,i)));
+		if (k < N-1) {
+			if (i > 0 && deps(k+1,i-1).fetch_sub(1) == 1)
+				start(i-1, k+1);
+			if (i < N-k-1 && deps(k+1,i).fetch_sub(1) == 1)
+				start(i, k+1);
+		}
+		done.count_down();
+	};
+
+	TIMERSTART(dataflow);
+	if (api == Api::COROUTINE) {
+		for (uint64_t k=0; k<N; ++k)
+			for (uint64_t i=0; i<(N-k); ++i)
+				dataflow_job(TP, k, i, M, events, done);
+	}
+	else {
+		for (uint64_t i=0; i<N; ++i)
+			start(i, 0);
+	}
+	done.wait();
+	TIMERSTOP(dataflow, time);
+	stats = TP.stats();
+	return M.size();
+}
+
+void print_usage() {
+	std::printf("usage: threadPool_bench [options]\n"
+				"     -h               prints this message\n"
+				"     -n num_tasks     number of tasks [default=%d]\n"
+				"     -T num_threads   number of threads [default=%d]\n"
+				"     -m min           min task time in us [default=%d]\n"
+				"     -M max           max task time in us [default=%d]\n"
+				"     -l file_name     log file name [default=%s]\n"
+				"     -p               whether to collect the statistics of the\n"
+				"                      pools and check that no more tasks than\n"
+				"                      the ones of a pattern are ever counted\n"
+				"                      as queued (fails otherwise) [not\n"
+				"                      collected by default]\n"
+				"     -r ring_slots    slots of the ring backend, the tasks\n"
+				"                      beyond them go to its overflow queue\n"
+				"                      [default=%d]\n",
+				DEFAULT_n, DEFAULT_T, DEFAULT_m, DEFAULT_M, DEFAULT_LOG_FILE,
+				DEFAULT_RING_SLOTS);
+}
+
+int main(int argc, char *argv[]) {
+	int min                   = DEFAULT_m;
+	int max                   = DEFAULT_M;
+	uint64_t n                = DEFAULT_n;
+	uint32_t T                = DEFAULT_T;
+	std::string log_file_name = DEFAULT_LOG_FILE;
+	bool collect_stats        = false;
+	uint64_t ring_slots       = DEFAULT_RING_SLOTS;
+
+	int opt;
+	while ((opt = getopt(argc, argv, "hn:T:m:M:l:pr:")) != -1) {
+		switch (opt) {
+			case 'h':
+				print_usage();
+				return 0;
+			case 'n':
+				n = atoi(optarg);
+				break;
+			case 'T':
+				T = atoi(optarg);
+				break;
+			case 'm':
+				min = atoi(optarg);
+				break;
+			case 'M':
+				max = atoi(optarg);
+				break;
+			case 'l':
+				log_file_name = optarg;
+				break;
+			case 'p':
+				collect_stats = true;
+				break;
+			case 'r':
+				ring_slots = std::max(atoi(optarg), 1);
+				break;
+			default:
+				print_usage();
+				return 1;
+		}
+	}
+
+	tsc_calibration(); // before anything is timed
+
+	std::mt19937 generator(117);
+	std::uniform_int_distribution<int> distribution(min, max);
+	std::vector<int> costs(n);
+	for (auto &cost : costs)
+		cost = distribution(generator);
+
+	// write the execution times to a file
+	// (backend, api, pattern, T, min, max, tasks, time, tasks per second);
+	// with -m 0 -M 0 the time per task is the overhead of the scheduling
+	std::ofstream file;
+	file.open(log_file_name, std::ios_base::app);
+	ThreadPool::Stats stats;
+	bool consistent = true;
+	auto log = [&] (ThreadPool::Backend backend, Api api, const char *pattern,
+		uint64_t tasks, double time) {
+		if (stats.queue_high_water > tasks) {
+			std::cerr << backend_name(backend) << " " << api_name(api) << " "
+				<< pattern << ": " << stats.queue_high_water
+				<< " tasks queued at once, out of " << tasks << ".\n";
+			consistent = false;
+		}
+		file << backend_name(backend) << "," << api_name(api) << "," << pattern
+			<< "," << T << "," << min << "," << max << "," << tasks << ","
+			<< time << "," << tasks/time << "\n";
+		std::printf("%-9s %-9s %-8s T=%u: %fs (%.0f tasks/s, %.0f ns per "
+			"task)\n", backend_name(backend), api_name(api), pattern, T, time,
+			tasks/time, time/tasks*1e9);
+	};
+	for (auto backend : {ThreadPool::Backend::CENTRAL,
+						 ThreadPool::Backend::WORK_STEALING,
+						 ThreadPool::Backend::PRIORITY,
+						 ThreadPool::Backend::RING}) {
+		for (Api api : {Api::ENQUEUE, Api::SUBMIT, Api::COROUTINE}) {
+			double time = bench_external(backend, api, costs, T,
+				collect_stats, ring_slots, stats);
+			log(backend, api, "external", n, time);
+			time = bench_spawn(backend, api, costs, T, collect_stats,
+				ring_slots, stats);
+			log(backend, api, "spawn", n, time);
+			uint64_t elements = bench_dataflow(backend, api, costs, T,
+				collect_stats, ring_slots, stats, time);
+			log(backend, api, "dataflow", elements, time);
+		}
+	}
+	file.close();
+
+	return consistent ? 0 : 1;
+}
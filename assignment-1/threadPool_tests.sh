@@ -0,0 +1,55 @@
+#!/bin/bash
+
+THREADS_STEP=4
+REPETITIONS=5
+NUM_TASKS=100000
+NUM_CORES=40
+LOGFILE="threadPool_bench_log.csv"
+
+# parsing command line arguments
+# (both optional, first one is the number of cores, second one is the log file)
+if [ $# -gt 0 ]; then
+    NUM_CORES=$1
+    if ! [[ $NUM_CORES =~ ^[0-9]+$ ]] ||
+        [ $NUM_CORES -lt 1 ] ||
+        [ $NUM_CORES -gt 60 ]; then
+        echo "Please provide a number in [1, 60] for the first argument."
+        exit 1
+    fi
+    if [ $# -gt 1 ]; then
+        LOGFILE=$2
+    fi
+fi
+
+# empty the log file
+truncate -s 0 $LOGFILE
+
+######################## COMPARING THE BACKENDS ################################
+echo "Comparing the central queue with work-stealing"
+for window in "0 0" "0 10" "0 100" "0 1000"; do
+    read min max <<< "$window"
+    for t in $(seq 0 $THREADS_STEP $NUM_CORES); do
+        thr=$((t == 0 ? t + 1 : t))
+        for rep in $(seq 1 $REPETITIONS); do
+            echo "[$rep/$REPETITIONS] T = $thr, n = $NUM_TASKS, min = $min, max = $max"
+            ./threadPool_bench -n $NUM_TASKS -T $thr -m $min -M $max -l $LOGFILE
+        done
+    done
+done
+
+######################## CHECKING THE QUEUE COUNTERS ###########################
+echo "Checking the queued tasks counted by the backends"
+for rep in $(seq 1 $REPETITIONS); do
+    echo "[$rep/$REPETITIONS] T = $NUM_CORES, n = $NUM_TASKS, min = 0, max = 0, statistics"
+    if ! ./threadPool_bench -n $NUM_TASKS -T $NUM_CORES -m 0 -M 0 -p -l /dev/null; then
+        echo "More tasks counted as queued than enqueued."
+        exit 1
+    fi
+done
+
+######################## FILLING THE RING ######################################
+echo "Running the backends with a ring of 16 slots (overflowing)"
+for rep in $(seq 1 $REPETITIONS); do
+    echo "[$rep/$REPETITIONS] T = $NUM_CORES, n = $NUM_TASKS, min = 0, max = 10, ring slots = 16"
+    ./threadPool_bench -n $NUM_TASKS -T $NUM_CORES -m 0 -M 10 -r 16 -p -l $LOGFILE || exit 1
+done
@@ -2,20 +2,61 @@
 #include <unistd.h>
 #include <vector>
 #include <thread>
-#include <random>
-#include <barrier>
+#include <latch>
+#include <atomic>
 #include <threadPool.hpp>
+#include <affinity.hpp>
+#include <packedMatrix.hpp>
+#include <dotMatrix.hpp>
+#include <wavefront.hpp>
+#include <executor.hpp>
+#include <completionEvent.hpp>
+#include <trace.hpp>
+#include <costs.hpp>
+#include <barrier.hpp>
+#include <spin.hpp>
 #include <fstream>
+#include <sstream>
+#include <cmath>
+#include <climits>
+#include <algorithm>
+#include <numeric>
+#include <map>
+#include <optional>
 
 #ifndef DEBUG
 	#define DEBUG 0
 #endif
 
 #define DEFAULT_LOG_FILE "wavefront_log.csv" // default log file name
+#define DEFAULT_TRACE_FILE "wavefront_trace.json" // trace of a TRACE build
+#define DEFAULT_DOT_LOG_FILE "wavefront_dot_log.csv" // same, dot workload
+#define DEFAULT_BENCH_LOG_FILE "wavefront_bench_log.csv" // same, benchmark mode
+#define DEFAULT_DETAIL_LOG_FILE "wavefront_detail_log.csv" // all the times and statistics
 #define DEFAULT_N 512 // default size of the square matrix (NxN)
 #define DEFAULT_T 2 // default number of threads
-#define DEFAULT_m 0 // default minimum time (in microseconds)
-#define DEFAULT_M 1000 // default maximum time (in microseconds)
+#define DEFAULT_m 0 // default minimum time (in units)
+#define DEFAULT_M 1000 // default maximum time (in units)
+#define DEFAULT_UNIT 1000 // default unit of the times (in ns, 1000 for microseconds)
+#define DEFAULT_QUEUE "central" // default task queue of the pool-based algorithms
+#define DEFAULT_SPINS 0 // default polls of an idle pool thread before yielding
+#define DEFAULT_YIELDS 0 // default polls of an idle pool thread before sleeping
+#define DEFAULT_WORKLOAD "busy" // default computation of the elements
+#define DEFAULT_DISTRIBUTION "uniform" // default distribution of the costs
+#define SEED 117 // stream of the random costs (the batch uses the next ones)
+#define DEFAULT_AFFINITY "none" // default placement of the threads
+#define DEFAULT_BARRIER "std" // default barrier of the static algorithms
+#define DEFAULT_REPS 1 // default runs of each parallel algorithm
+#define DEFAULT_INSTANCES 0 // default matrices of the batch (0 for no batch)
+#define DEFAULT_WINDOW 2 // default matrices of the batch in flight
+#define DEFAULT_C 1 // default minimum chunk size of the guided algorithm
+#define DEFAULT_B 0 // default tile size (0 to choose it from the costs)
+#define TILE_COST 200000 // target cost of a tile in the auto mode (in nanoseconds)
+#define DEFAULT_ALGORITHMS "dynamic,static,balanced,guided,doacross,dataflow,"\
+	"priority,coroutine,tiled" // default algorithms of the benchmark mode
+#define DEFAULT_MAIN_ALGORITHMS "dynamic,static" // same, outside the benchmark mode
+#define DEFAULT_WARMUP 1 // default untimed runs of each point of the benchmark
+#define DEFAULT_BENCH_REPS 10 // default timed runs of each point of the benchmark
 
 #define DEBUG_PRINT(fmt, ...)\
 	if (DEBUG) {{\
@@ -35,110 +76,1039 @@
 	std::chrono::duration<double> delta##label = b##label-a##label;\
 	time_elapsed = delta##label.count();
 
-int random(const int &min, const int &max) {
-	static std::mt19937 generator(117);
-	std::uniform_int_distribution<int> distribution(min,max);
-	return distribution(generator);
+void work(std::chrono::nanoseconds w) {
+	spin_for(w);
+}
+
+// upper triangle stored diagonal by diagonal, M(k,i) is the element (i,i+k)
+// (its cost in nanoseconds)
+using Matrix = PackedMatrix<int>;
+
+// computes the i-th element of the k-th diagonal (traced as busy time)
+inline void compute_element(const Matrix &M, const uint64_t &k,
+	const uint64_t &i) {
+	TraceScope scope(TraceKind::ELEMENT, i, k);
+	work(std::chrono::nanoseconds(M(k,i)));
+}
+
+// configuration of the executor running the parallel algorithms
+struct PoolConfig {
+	ThreadPool::Backend backend;
+	ThreadPool::IdlePolicy idle;
+	std::vector<int> cpus; // where to pin the threads, if not empty
+	bool stats = false; // whether the pool collects statistics
 };
 
-void work(std::chrono::microseconds w) {
-	auto end = std::chrono::steady_clock::now() + w;
-	while(std::chrono::steady_clock::now() < end);
+// cost(k,i) in units of unit nanoseconds, as nanoseconds
+template <typename Cost>
+struct Scaled {
+	Cost cost;
+	uint64_t unit;
+
+	Scaled(Cost cost_, uint64_t unit_) :
+		cost(std::move(cost_)),
+		unit(unit_) {}
+
+	int operator()(const uint64_t &k, const uint64_t &i) const {
+		return cost(k,i)*unit;
+	}
+};
+
+// sets M(k,i) to cost(k,i) and returns the sum of the costs: the workers
+// of the executor write the id-th of T contiguous blocks of each diagonal
+// (the matrix is not written on allocation), so that the pages of a block
+// are local to the socket of the thread, and the initialization of a large
+// matrix is not serial (cost must be callable from any thread)
+template <typename Cost>
+uint64_t fill_costs(
+	Matrix &M,
+	const uint64_t &N,
+	const uint32_t &T,
+	const Cost &cost,
+	Executor &ex
+	) {
+
+	std::vector<uint64_t> sums(T, 0);
+	auto fill = [&] (const uint64_t id) -> void {
+		uint64_t sum = 0;
+		for (uint64_t k=0; k<N; ++k) { // for each upper diagonal
+			for (uint64_t i=id*(N-k)/T; i<(id+1)*(N-k)/T; ++i) {
+				M(k,i) = cost(k,i);
+				sum += M(k,i);
+			}
+		}
+		sums[id] = sum;
+	};
+
+	ex.run(fill);
+	return std::accumulate(sums.begin(), sums.end(), uint64_t(0));
 }
 
-// parallel wavefront algorithm with static scheduling
+// parallel wavefront algorithm with static scheduling, the id-th thread
+// computes the id-th of T contiguous blocks of each diagonal (the ones it
+// wrote in fill_costs)
+template <typename Barrier>
 void wavefront_parallel_static(
-	const std::vector<int> &M,
+	const Matrix &M,
 	const uint64_t &N,
-	const uint32_t &T
+	const uint32_t &T,
+	Barrier &bar,
+	Executor &ex
 	) {
 
-		std::barrier bar(T);
-
 		auto static_task = [&] (const uint64_t id) -> void {
 			for (uint64_t k=0; k<N; ++k) { // for each upper diagonal
-				if (id >= N-k) {
-					bar.arrive_and_drop();
-					DEBUG_PRINT("Thread %lu: exit\n", id)
-					return;
+				// for each assigned elem.
+				for (uint64_t i=id*(N-k)/T; i<(id+1)*(N-k)/T; ++i) {
+					compute_element(M, k, i);
+					DEBUG_PRINT("Thread %lu: computed element (%lu,%lu)\n",
+						id, i, i+k)
 				}
-				for (uint64_t i=id; i<N-k; i+=T) { // for each assigned elem.
-					work(std::chrono::microseconds(M[i*N+(i+k)]));
-					DEBUG_PRINT("Thread %lu: computed index %lu\n",
-						id, i*N+(i+k))
+				{
+					TraceScope scope(TraceKind::BARRIER, 0, k);
+					bar.arrive_and_wait(id);
 				}
-				bar.arrive_and_wait();
 				DEBUG_PRINT("Thread %lu: unlocked from waiting\n", id)
 			}
 		};
 
-		std::vector<std::thread> threads;
-		for (uint64_t id=0; id<T; id++)
-			threads.emplace_back(static_task, id);
+		ex.run(static_task);
+	}
 
-		for (auto &thread : threads)
-			thread.join();
+// contiguous partition of every diagonal among T threads: the id-th
+// thread computes the elements [begin(k,id), end(k,id)) of the k-th one
+struct Partition {
+	uint32_t T;
+	std::vector<uint64_t> bounds; // T+1 per diagonal
+
+	uint64_t begin(const uint64_t &k, const uint64_t &id) const {
+		return bounds[k*(T+1)+id];
 	}
 
-// parallel wavefront algorithm with dynamic scheduling
-void wavefront_parallel_dynamic(
-	const std::vector<int> &M,
+	uint64_t end(const uint64_t &k, const uint64_t &id) const {
+		return bounds[k*(T+1)+id+1];
+	}
+
+	// the thread computing the i-th element of the k-th diagonal
+	uint32_t owner(const uint64_t &k, const uint64_t &i) const {
+		auto first = bounds.begin()+k*(T+1);
+		return std::upper_bound(first, first+T+1, i)-first-1;
+	}
+};
+
+// splits n items into T contiguous blocks of the same total cost, writing
+// the T+1 bounds: an item goes to the next block if more than half of it
+// would fall past the share of the current one (by count if all costs
+// are zero)
+template <typename Cost>
+void balanced_split(
+	const Cost *costs,
+	const uint64_t &n,
+	const uint32_t &T,
+	uint64_t *bounds
+	) {
+
+	double total = std::accumulate(costs, costs+n, 0.0);
+	double prefix = 0;
+	uint32_t t = 1;
+	bounds[0] = 0;
+	for (uint64_t i=0; i<n && t<T; ++i) { // for each item
+		double cost = (total > 0) ? costs[i] : 1;
+		double share = ((total > 0) ? total : n)*t/T;
+		while (t < T && prefix+cost/2 > share) {
+			bounds[t++] = i;
+			share = ((total > 0) ? total : n)*t/T;
+		}
+		prefix += cost;
+	}
+	while (t <= T)
+		bounds[t++] = n;
+}
+
+// splits each diagonal so that the threads get the same total cost
+Partition balanced_partition(
+	const Matrix &M,
 	const uint64_t &N,
 	const uint32_t &T
 	) {
 
-	std::barrier bar(T);
+	Partition partition{T, std::vector<uint64_t>(N*(T+1))};
+	for (uint64_t k=0; k<N; ++k) // for each upper diagonal
+		balanced_split(M.diagonal(k), N-k, T, &partition.bounds[k*(T+1)]);
+	return partition;
+}
 
-	auto process_element = [&](uint64_t index, bool block) {
-		work(std::chrono::microseconds(M[index]));
-		if (block) {
-			bar.arrive_and_wait();
-			DEBUG_PRINT("Computed index %lu and waited\n", index)
+// sum over the diagonals of the cost of the most loaded thread, divided by
+// the sum of the mean costs per thread: 1 means perfect balance, the
+// higher the longer threads wait at the barriers
+template <typename Owner>
+double imbalance(
+	const Matrix &M,
+	const uint64_t &N,
+	const uint32_t &T,
+	Owner &&owner
+	) {
+
+	double max_sum = 0, mean_sum = 0;
+	std::vector<double> loads(T);
+	for (uint64_t k=0; k<N; ++k) { // for each upper diagonal
+		std::fill(loads.begin(), loads.end(), 0);
+		for (uint64_t i=0; i<(N-k); ++i) // for each elem. in the diagonal
+			loads[owner(k,i)] += M(k,i);
+		max_sum += *std::max_element(loads.begin(), loads.end());
+		mean_sum += std::accumulate(loads.begin(), loads.end(), 0.0)/T;
+	}
+	return (mean_sum > 0) ? max_sum/mean_sum : 1;
+}
+
+// parallel wavefront algorithm with static scheduling, each diagonal is
+// split among the threads according to a (cost-aware) partition
+template <typename Barrier>
+void wavefront_parallel_static_balanced(
+	const Matrix &M,
+	const uint64_t &N,
+	const uint32_t &T,
+	const Partition &partition,
+	Barrier &bar,
+	Executor &ex
+	) {
+
+	auto static_task = [&] (const uint64_t id) -> void {
+		for (uint64_t k=0; k<N; ++k) { // for each upper diagonal
+			for (uint64_t i=partition.begin(k,id); i<partition.end(k,id); ++i) {
+				compute_element(M, k, i);
+				DEBUG_PRINT("Thread %lu: computed element (%lu,%lu)\n",
+					id, i, i+k)
+			}
+			{
+				TraceScope scope(TraceKind::BARRIER, 0, k);
+				bar.arrive_and_wait(id);
+			}
 		}
-		else {
-			DEBUG_PRINT("Computed index %lu without waiting\n", index)
+	};
+
+	ex.run(static_task);
+}
+
+// splits the rows into T contiguous bands of the same total cost, the
+// id-th thread owns the rows [bands[id], bands[id+1])
+std::vector<uint64_t> balanced_bands(
+	const Matrix &M,
+	const uint64_t &N,
+	const uint32_t &T
+	) {
+
+	std::vector<double> rows(N, 0);
+	for (uint64_t k=0; k<N; ++k) // for each upper diagonal
+		for (uint64_t i=0; i<(N-k); ++i) // for each elem. in the diagonal
+			rows[i] += M(k,i);
+	std::vector<uint64_t> bands(T+1);
+	balanced_split(rows.data(), N, T, bands.data());
+	return bands;
+}
+
+// parallel wavefront algorithm with point-to-point synchronization
+// (doacross): each thread owns a band of rows and, as (i,i+k) depends on
+// (i,i+k-1) and (i+1,i+k), before the k-th diagonal it only waits for the
+// thread of the band below to be done with the (k-1)-th one, so that the
+// threads are pipelined across the diagonals instead of meeting at barriers
+void wavefront_parallel_doacross(
+	const Matrix &M,
+	const uint64_t &N,
+	const uint32_t &T,
+	const std::vector<uint64_t> &bands,
+	Executor &ex
+	) {
+
+	// diagonals completed by each thread, each counter on its own cache line
+	struct alignas(64) Progress {
+		std::atomic<uint64_t> diagonals{0};
+	};
+	std::unique_ptr<Progress[]> progress(new Progress[T]);
+
+	auto doacross_task = [&] (const uint64_t id) -> void {
+		const uint64_t first = bands[id], last = bands[id+1];
+		// past the diagonal N-first the band is empty, and the thread of
+		// the band above needs no more than N-first diagonals of this one
+		for (uint64_t k=0; k<N && first<N-k; ++k) { // for each upper diagonal
+			// the last row of the band needs the row below on the
+			// previous diagonal (an empty band just forwards it)
+			if (k > 0 && id+1 < T && last <= N-k) {
+				std::atomic<uint64_t> &below = progress[id+1].diagonals;
+				TraceScope scope(TraceKind::BARRIER, 0, k);
+				spin_until([&] ( ) -> bool {
+					return below.load(std::memory_order_acquire) >= k;
+				});
+			}
+			for (uint64_t i=first; i<std::min(last, N-k); ++i) { // own rows
+				compute_element(M, k, i);
+				DEBUG_PRINT("Thread %lu: computed element (%lu,%lu)\n",
+					id, i, i+k)
+			}
+			progress[id].diagonals.store(k+1, std::memory_order_release);
 		}
 	};
 
-	auto wait = [&] () {
-		bar.arrive_and_wait();
-		DEBUG_PRINT("Waited\n")
+	ex.run(doacross_task);
+}
+
+// parallel wavefront algorithm with guided self-scheduling: T persistent
+// threads claim chunks of the current diagonal from an atomic cursor, a
+// chunk being 1/T of the elements left but at least C elements
+template <typename Barrier>
+void wavefront_parallel_guided(
+	const Matrix &M,
+	const uint64_t &N,
+	const uint32_t &T,
+	const uint64_t &C,
+	Barrier &bar,
+	Executor &ex
+	) {
+
+	// cursors of even and odd diagonals: the one of the next diagonal
+	// is reset while the threads are working on the current one
+	struct alignas(64) Cursor {
+		std::atomic<uint64_t> next{0};
+	} cursors[2];
+
+	auto guided_task = [&] (const uint64_t id) -> void {
+		for (uint64_t k=0; k<N; ++k) { // for each upper diagonal
+			std::atomic<uint64_t> &next = cursors[k%2].next;
+			uint64_t begin = next.load(std::memory_order_relaxed);
+			while (begin < N-k) {
+				uint64_t chunk = std::max(C, (N-k-begin+T-1)/T);
+				if (!next.compare_exchange_weak(begin, begin+chunk,
+					std::memory_order_relaxed))
+					continue; // begin now holds the current cursor
+				uint64_t end = std::min(begin+chunk, N-k);
+				for (uint64_t i=begin; i<end; ++i) { // for each claimed elem.
+					compute_element(M, k, i);
+					DEBUG_PRINT("Thread %lu: computed element (%lu,%lu)\n",
+						id, i, i+k)
+				}
+				begin = next.load(std::memory_order_relaxed);
+			}
+			// nobody uses the cursor of the next diagonal
+			// until all threads have passed the barrier
+			if (id == 0)
+				cursors[(k+1)%2].next.store(0, std::memory_order_relaxed);
+			{
+				TraceScope scope(TraceKind::BARRIER, 0, k);
+				bar.arrive_and_wait(id);
+			}
+		}
+	};
+
+	ex.run(guided_task);
+}
+
+// parallel wavefront algorithm with dynamic scheduling
+void wavefront_parallel_dynamic(
+	const Matrix &M,
+	const uint64_t &N,
+	const uint32_t &T,
+	ThreadPool &TP
+	) {
+
+	auto process_element = [&](uint64_t k, uint64_t i) {
+		compute_element(M, k, i);
+		DEBUG_PRINT("Computed element (%lu,%lu)\n", i, i+k)
 	};
 
-	ThreadPool TP(T);
 	for (uint64_t k=0; k<N; ++k) { // for each upper diagonal
-		if ((N-k)<T) { // if the diagonal is smaller than the number of threads
-			for (uint64_t i=(N-k); i<T; ++i) { // for each extra thread
-				TP.enqueue(wait);
+		// the threads claim the elements one at a time,
+		// the diagonal is over when parallel_for returns
+		TP.parallel_for(0, N-k, 1, [&, k](uint64_t i) {
+			process_element(k, i);
+		});
+	}
+}
+
+// number of predecessors still to be computed for each element of the
+// dataflow algorithms, set to 2 (the main diagonal is not used): built
+// out of the timed runs, every element sets its own counter back to 2
+// when it runs, so the counters are ready for the next solve
+PackedMatrix<std::atomic<uint8_t>> dependency_counters(const uint64_t &N) {
+	PackedMatrix<std::atomic<uint8_t>> deps(N);
+	for (uint64_t k=1; k<N; ++k)
+		for (uint64_t i=0; i<(N-k); ++i)
+			deps(k,i).store(2, std::memory_order_relaxed);
+	return deps;
+}
+
+// parallel wavefront algorithm with dataflow scheduling: an element is
+// submitted to the pool as soon as its two predecessors have been computed
+// (deps from dependency_counters)
+void wavefront_parallel_dataflow(
+	const Matrix &M,
+	const uint64_t &N,
+	const uint32_t &T,
+	PackedMatrix<std::atomic<uint8_t>> &deps,
+	ThreadPool &TP
+	) {
+
+	// counted down by each element as the last action of its task: the
+	// pool outlives the solve, the function and the counters must not be
+	// destroyed while a thread is still in the middle of a task
+	std::latch done(N*(N+1)/2);
+
+	std::function<void(uint64_t, uint64_t)> process_element;
+	process_element = [&](uint64_t i, uint64_t k) {
+		if (k > 0) // all the predecessors are done
+			deps(k,i).store(2, std::memory_order_relaxed);
+		compute_element(M, k, i);
+		DEBUG_PRINT("Computed element (%lu,%lu)\n", i, i+k)
+		// elements (i-1,i+k) and (i,i+k+1) depend on (i,i+k)
+		if (k < N-1) {
+			if (i > 0 && deps(k+1,i-1).fetch_sub(1) == 1)
+				TP.submit(std::ref(process_element), i-1, k+1);
+			if (i < N-k-1 && deps(k+1,i).fetch_sub(1) == 1)
+				TP.submit(std::ref(process_element), i, k+1);
+		}
+		done.count_down();
+	};
+
+	for (uint64_t i=0; i<N; ++i) // the main diagonal is ready
+		TP.submit(std::ref(process_element), i, 0);
+	done.wait();
+}
+
+// remaining critical path of each element: the cost of the longest chain
+// of elements from it to the last one, (i,i+k) being followed by (i-1,i+k)
+// and (i,i+k+1)
+PackedMatrix<uint64_t> critical_paths(const Matrix &M, const uint64_t &N) {
+	PackedMatrix<uint64_t> paths(N);
+	for (uint64_t k=N; k-- > 0;) { // from the last diagonal
+		for (uint64_t i=0; i<(N-k); ++i) {
+			uint64_t next = 0;
+			if (k < N-1) {
+				if (i > 0)
+					next = paths(k+1,i-1);
+				if (i < N-k-1)
+					next = std::max(next, paths(k+1,i));
 			}
+			paths(k,i) = M(k,i)+next;
 		}
-		for (uint64_t i=0; i<(N-k); ++i) { // for each elem. in the diagonal
-			bool block = (i >= (N-k-T) || (N-k)<T) ? true : false;
-			TP.enqueue(process_element, i*N+(i+k), block);
+	}
+	return paths;
+}
+
+// whether bytes can be allocated without swapping, i.e. fit in the free
+// physical memory
+bool fits_in_memory(const uint64_t &bytes) {
+	return bytes < static_cast<uint64_t>(sysconf(_SC_AVPHYS_PAGES))*
+		sysconf(_SC_PAGESIZE);
+}
+
+// parallel wavefront algorithm with dataflow scheduling and critical-path
+// priorities: as the dataflow one, but each ready element is submitted
+// with its remaining critical path as priority, so that with the priority
+// backend the threads compute first the elements the makespan depends on
+void wavefront_parallel_dataflow_priority(
+	const Matrix &M,
+	const uint64_t &N,
+	const uint32_t &T,
+	const PackedMatrix<uint64_t> &paths,
+	PackedMatrix<std::atomic<uint8_t>> &deps,
+	ThreadPool &TP
+	) {
+
+	std::latch done(N*(N+1)/2);
+
+	std::function<void(uint64_t, uint64_t)> process_element;
+	process_element = [&](uint64_t i, uint64_t k) {
+		if (k > 0) // all the predecessors are done
+			deps(k,i).store(2, std::memory_order_relaxed);
+		compute_element(M, k, i);
+		DEBUG_PRINT("Computed element (%lu,%lu)\n", i, i+k)
+		if (k < N-1) {
+			if (i > 0 && deps(k+1,i-1).fetch_sub(1) == 1)
+				TP.submit_priority(paths(k+1,i-1), std::ref(process_element),
+					i-1, k+1);
+			if (i < N-k-1 && deps(k+1,i).fetch_sub(1) == 1)
+				TP.submit_priority(paths(k+1,i), std::ref(process_element),
+					i, k+1);
 		}
+		done.count_down();
+	};
+
+	for (uint64_t i=0; i<N; ++i) // the main diagonal is ready
+		TP.submit_priority(paths(0,i), std::ref(process_element), i, 0);
+	done.wait();
+}
+
+// an element of the coroutine algorithm: it waits for its two predecessors
+// (an element of the main diagonal just moves to the pool), is computed and
+// sets its event; the indices are taken by value, the frame outlives the
+// call that starts the coroutine
+Job element_job(
+	const Matrix &M,
+	uint64_t k,
+	uint64_t i,
+	PackedMatrix<CompletionEvent> &events,
+	ThreadPool &TP,
+	std::latch &done
+	) {
+
+	if (k == 0)
+		co_await TP.schedule();
+	else // (i,i+k) depends on (i,i+k-1) and (i+1,i+k)
+		co_await when_all(TP, events(k-1,i), events(k-1,i+1));
+	compute_element(M, k, i);
+	DEBUG_PRINT("Computed element (%lu,%lu)\n", i, i+k)
+	events(k,i).set();
+	done.count_down();
+}
+
+// parallel wavefront algorithm with coroutines: all the elements are
+// started at once, each one suspended on the completion events of its
+// predecessors and resumed on the pool when both are set, as a single
+// task; unlike the dataflow one, no dependency counters nor submissions
+// are written in the algorithm
+void wavefront_parallel_coroutine(
+	const Matrix &M,
+	const uint64_t &N,
+	const uint32_t &T,
+	ThreadPool &TP
+	) {
+
+	PackedMatrix<CompletionEvent> events(N);
+
+	// counted down by each element as its last access to the solve,
+	// as in the dataflow algorithm
+	std::latch done(N*(N+1)/2);
+
+	// diagonal by diagonal, the first ones start running while the others
+	// are being started
+	for (uint64_t k=0; k<N; ++k)
+		for (uint64_t i=0; i<(N-k); ++i)
+			element_job(M, k, i, events, TP, done);
+	done.wait();
+}
+
+// parallel wavefront algorithm on a batch of independent matrices: the
+// diagonals of a matrix are split in (at most) T chunks, and the chunk
+// completing a diagonal submits the chunks of the next one; up to W
+// matrices are in flight, the one completing a matrix starts the next of
+// the batch, so that the threads left idle by the short diagonals at the
+// tail of a matrix compute the ones at the head of another
+void wavefront_parallel_batch(
+	const std::vector<Matrix> &batch,
+	const uint64_t &N,
+	const uint32_t &T,
+	const uint64_t &W,
+	ThreadPool &TP
+	) {
+
+	// chunks of the k-th diagonal
+	auto grain = [&](uint64_t k) -> uint64_t { return (N-k+T-1)/T; };
+	auto chunks = [&](uint64_t k) -> uint64_t {
+		return (N-k+grain(k)-1)/grain(k);
+	};
+
+	// elements of the current diagonal of each matrix still to be computed
+	struct alignas(64) Progress {
+		std::atomic<uint64_t> remaining{0};
+	};
+	std::unique_ptr<Progress[]> progress(new Progress[batch.size()]);
+	std::atomic<uint64_t> next_matrix{std::min<uint64_t>(W, batch.size())};
+
+	// counted down at the end of every chunk task, as in the dataflow
+	// algorithm the state must outlive the tasks
+	uint64_t total_chunks = 0;
+	for (uint64_t k=0; k<N; ++k)
+		total_chunks += chunks(k);
+	std::latch done(total_chunks*batch.size());
+
+	std::function<void(uint64_t, uint64_t)> start_diagonal;
+	std::function<void(uint64_t, uint64_t, uint64_t)> process_chunk;
+
+	// submits the chunks of the k-th diagonal of the m-th matrix
+	start_diagonal = [&](uint64_t m, uint64_t k) {
+		progress[m].remaining.store(N-k, std::memory_order_relaxed);
+		for (uint64_t begin=0; begin<N-k; begin+=grain(k))
+			TP.submit(std::ref(process_chunk), m, k, begin);
+	};
+
+	process_chunk = [&](uint64_t m, uint64_t k, uint64_t begin) {
+		uint64_t end = std::min(begin+grain(k), N-k);
+		for (uint64_t i=begin; i<end; ++i) // for each elem. in the chunk
+			compute_element(batch[m], k, i);
+		DEBUG_PRINT("Computed chunk [%lu,%lu) of diagonal %lu of matrix %lu\n",
+			begin, end, k, m)
+		if (progress[m].remaining.fetch_sub(end-begin) == end-begin) {
+			if (k+1 < N)
+				start_diagonal(m, k+1);
+			else {
+				uint64_t next = next_matrix.fetch_add(1);
+				if (next < batch.size())
+					start_diagonal(next, 0);
+			}
+		}
+		done.count_down();
+	};
+
+	for (uint64_t m=0; m<std::min<uint64_t>(W, batch.size()); ++m)
+		start_diagonal(m, 0);
+	done.wait();
+}
+
+// picks the tile size so that a tile costs about TILE_COST nanoseconds,
+// while keeping at least T tiles on the first diagonal of tiles
+uint64_t auto_tile_size(const double &mean_cost, const uint64_t &N,
+	const uint32_t &T) {
+	uint64_t max_B = std::max<uint64_t>(1, N/T);
+	if (mean_cost <= 0)
+		return max_B;
+	uint64_t B = std::ceil(std::sqrt(TILE_COST/mean_cost));
+	return std::clamp<uint64_t>(B, 1, max_B);
+}
+
+// parallel wavefront algorithm on BxB tiles: the tiles on a diagonal of
+// tiles are computed in parallel, each one by a single thread
+void wavefront_parallel_tiled(
+	const Matrix &M,
+	const uint64_t &N,
+	const uint32_t &T,
+	const uint64_t &B,
+	ThreadPool &TP
+	) {
+
+	// computes the elements of the tile (I,J) in wavefront order
+	auto process_tile = [&](uint64_t I, uint64_t J) {
+		uint64_t row_begin = I*B, row_end = std::min(N, (I+1)*B);
+		uint64_t col_begin = J*B, col_end = std::min(N, (J+1)*B);
+		uint64_t d_begin = (col_begin >= row_end) ? col_begin-row_end+1 : 0;
+		uint64_t d_end = col_end-row_begin;
+		for (uint64_t d=d_begin; d<d_end; ++d) { // for each diagonal in tile
+			uint64_t i_begin = std::max(row_begin,
+				(col_begin > d) ? col_begin-d : 0);
+			uint64_t i_end = std::min(row_end, col_end-d);
+			for (uint64_t i=i_begin; i<i_end; ++i) // for each elem. in tile
+				compute_element(M, d, i);
+		}
+		DEBUG_PRINT("Computed tile (%lu,%lu)\n", I, J)
+	};
+
+	uint64_t tiles = (N+B-1)/B;
+	for (uint64_t K=0; K<tiles; ++K) { // for each upper diagonal of tiles
+		TP.parallel_for(0, tiles-K, 1, [&, K](uint64_t I) {
+			process_tile(I, I+K);
+		});
+	}
+}
+
+// times reps runs of solve: the first one (cold) and the mean of the
+// others (steady state, -1 if there are none)
+template <typename Solve>
+void measure(
+	Solve &&solve,
+	const uint64_t &reps,
+	double &cold_time,
+	double &steady_time
+	) {
+
+	TIMERSTART(cold_run);
+	solve();
+	TIMERSTOP(cold_run, cold_time);
+	steady_time = -1;
+	if (reps > 1) {
+		TIMERSTART(steady_runs);
+		for (uint64_t r=1; r<reps; ++r)
+			solve();
+		TIMERSTOP(steady_runs, steady_time);
+		steady_time /= reps-1;
 	}
 }
 
 // sequential wavefront algorithm
-void wavefront_sequential(const std::vector<int> &M, const uint64_t &N) {
+void wavefront_sequential(const Matrix &M, const uint64_t &N) {
 	for(uint64_t k=0; k< N; ++k) { // for each upper diagonal
 		for(uint64_t i=0; i<(N-k); ++i) { // for each elem. in the diagonal
-			work(std::chrono::microseconds(M[i*N+(i+k)])); 
+			compute_element(M, k, i);
 		}
 	}
 }
 
+// executes the dot-product wavefront (the elements are computed from the
+// ones on their left and below, see DotMatrix) with the generic engine,
+// from the first upper diagonal as the main one is given; checks that the
+// parallel schedulers get the same result as the sequential one and logs
+// the cold and steady state times (returns 1 if a result is wrong)
+int dot_main(
+	const uint64_t &N,
+	const uint32_t &T,
+	const std::string &barrier,
+	const uint64_t &reps,
+	Executor &ex,
+	const std::string &log_file_name
+	) {
+
+	// sequential execution (the reference result), the runs after
+	// the first one recompute the same values in place
+	DotMatrix expected(N);
+	double seq_totaltime, seq_steadytime;
+	measure([&]() {
+		wavefront([&](uint64_t i, uint64_t j) { expected.compute(j-i, i); },
+			SequentialScheduler(), UpperTriangle(N, 1));
+	}, reps, seq_totaltime, seq_steadytime);
+
+	// parallel static execution
+	DotMatrix D_static(N);
+	double par_static_totaltime, par_static_steadytime;
+	measure([&]() {
+		with_barrier(barrier, T, ex.placement(), [&](auto &bar) {
+			wavefront([&](uint64_t i, uint64_t j) { D_static.compute(j-i, i); },
+				StaticScheduler(bar, ex), UpperTriangle(N, 1));
+		});
+	}, reps, par_static_totaltime, par_static_steadytime);
+	bool static_ok = (D_static == expected);
+
+	// parallel dynamic execution
+	DotMatrix D_dynamic(N);
+	double par_dynamic_totaltime, par_dynamic_steadytime;
+	measure([&]() {
+		wavefront([&](uint64_t i, uint64_t j) { D_dynamic.compute(j-i, i); },
+			DynamicScheduler(ex.pool()), UpperTriangle(N, 1));
+	}, reps, par_dynamic_totaltime, par_dynamic_steadytime);
+	bool dynamic_ok = (D_dynamic == expected);
+
+	if (!static_ok)
+		std::cerr << "The result of the static algorithm is wrong.\n";
+	if (!dynamic_ok)
+		std::cerr << "The result of the dynamic algorithm is wrong.\n";
+	if (DEBUG) std::printf("Top right element: %.17g\n", expected(0, N-1));
+
+	// write the execution times to a file
+	std::ofstream file;
+	file.open(log_file_name, std::ios_base::app);
+	file << N << "," << T << "," << seq_totaltime << ","
+		<< par_static_totaltime << "," << par_dynamic_totaltime << ","
+		<< static_ok << "," << dynamic_ok << "," << barrier << "," << reps
+		<< "," << seq_steadytime << "," << par_static_steadytime << ","
+		<< par_dynamic_steadytime << "\n";
+	file.close();
+
+	return (static_ok && dynamic_ok) ? 0 : 1;
+}
+
+// the algorithms of the benchmark mode
+const std::vector<std::string> algorithms = {"sequential", "dynamic", "static",
+	"balanced", "guided", "doacross", "dataflow", "priority", "coroutine",
+	"tiled"};
+
+// a solve of the matrix with the algorithm named mode, on the threads of ex:
+// what the algorithm computes from the costs (partition, bands, critical
+// paths, tile size), its barrier and its pool (created on first use) are
+// built here, out of the timed runs
+std::function<void()> make_solver(
+	const std::string &mode,
+	const Matrix &M,
+	const uint64_t &N,
+	const double &mean_cost,
+	const std::string &barrier,
+	const uint64_t &C,
+	const uint64_t &B,
+	Executor &ex
+	) {
+
+	const uint32_t T = ex.size();
+	if (mode == "sequential")
+		return [&M, N]() { wavefront_sequential(M, N); };
+	if (mode == "dynamic")
+		return [&M, N, T, &TP=ex.pool()]() {
+			wavefront_parallel_dynamic(M, N, T, TP);
+		};
+	if (mode == "static")
+		return bind_barrier(barrier, T, ex.placement(),
+			[&M, N, T, &ex](auto &bar) {
+				wavefront_parallel_static(M, N, T, bar, ex);
+			});
+	if (mode == "balanced") {
+		auto partition = std::make_shared<Partition>(balanced_partition(M, N, T));
+		return bind_barrier(barrier, T, ex.placement(),
+			[&M, N, T, partition, &ex](auto &bar) {
+				wavefront_parallel_static_balanced(M, N, T, *partition, bar, ex);
+			});
+	}
+	if (mode == "guided")
+		return bind_barrier(barrier, T, ex.placement(),
+			[&M, N, T, C, &ex](auto &bar) {
+				wavefront_parallel_guided(M, N, T, C, bar, ex);
+			});
+	if (mode == "doacross")
+		return [&M, N, T, bands=balanced_bands(M, N, T), &ex]() {
+			wavefront_parallel_doacross(M, N, T, bands, ex);
+		};
+	if (mode == "dataflow") {
+		auto deps = std::make_shared<PackedMatrix<std::atomic<uint8_t>>>(
+			dependency_counters(N));
+		return [&M, N, T, deps, &TP=ex.pool()]() {
+			wavefront_parallel_dataflow(M, N, T, *deps, TP);
+		};
+	}
+	if (mode == "priority") {
+		auto paths = std::make_shared<PackedMatrix<uint64_t>>(
+			critical_paths(M, N));
+		auto deps = std::make_shared<PackedMatrix<std::atomic<uint8_t>>>(
+			dependency_counters(N));
+		return [&M, N, T, paths, deps,
+			&TP=ex.pool(ThreadPool::Backend::PRIORITY)]() {
+			wavefront_parallel_dataflow_priority(M, N, T, *paths, *deps, TP);
+		};
+	}
+	if (mode == "coroutine")
+		return [&M, N, T, &TP=ex.pool()]() {
+			wavefront_parallel_coroutine(M, N, T, TP);
+		};
+	if (mode == "tiled")
+		return [&M, N, T, B=(B ? B : auto_tile_size(mean_cost, N, T)),
+			&TP=ex.pool()]() {
+			wavefront_parallel_tiled(M, N, T, B, TP);
+		};
+	throw std::invalid_argument("unknown algorithm `" + mode + "`");
+}
+
+// order statistics, mean and standard deviation of the times of a point
+// of the benchmark (percentiles interpolated between the closest runs)
+struct Summary {
+	double median, p10, p90, mean, stddev;
+
+	explicit Summary(std::vector<double> times) {
+		std::sort(times.begin(), times.end());
+		auto percentile = [&](double p) -> double {
+			double rank = p*(times.size()-1);
+			uint64_t below = static_cast<uint64_t>(rank);
+			uint64_t above = std::min<uint64_t>(below+1, times.size()-1);
+			return times[below]+(rank-below)*(times[above]-times[below]);
+		};
+		median = percentile(0.5);
+		p10 = percentile(0.1);
+		p90 = percentile(0.9);
+		mean = std::accumulate(times.begin(), times.end(), 0.0)/times.size();
+		double squares = 0;
+		for (const double &time : times)
+			squares += (time-mean)*(time-mean);
+		stddev = (times.size() > 1) ? std::sqrt(squares/(times.size()-1)) : 0;
+	}
+};
+
+// what the benchmark mode runs
+struct BenchConfig {
+	std::vector<int> threads;           // the thread counts to sweep
+	std::vector<std::string> modes;     // the algorithms
+	uint64_t warmup = DEFAULT_WARMUP;   // untimed runs of each point
+	uint64_t reps = DEFAULT_BENCH_REPS; // timed runs of each point
+};
+
+// splits a comma separated list
+std::vector<std::string> split_list(const std::string &list) {
+	std::vector<std::string> items;
+	std::istringstream stream(list);
+	std::string item;
+	while (std::getline(stream, item, ','))
+		if (!item.empty())
+			items.push_back(item);
+	return items;
+}
+
+// benchmark mode: for each thread count an executor is created (and its
+// startup is not timed), then each algorithm is run bench.warmup times
+// and timed bench.reps times on the same matrix. The speedup is relative
+// to the median of the sequential algorithm if sequential_time is -1 or
+// it is among the algorithms (it is then timed once, as the other
+// points), else to sequential_time. Logs a row per point: median, p10,
+// p90, mean, standard deviation, speedup and efficiency
+void bench_main(
+	const Matrix &M,
+	const uint64_t &N,
+	const double &mean_cost,
+	double sequential_time,
+	const BenchConfig &bench,
+	const PoolConfig &pool,
+	const std::string &affinity,
+	const std::string &barrier,
+	const uint64_t &C,
+	const uint64_t &B,
+	const std::string &costs,
+	const std::string &log_file_name
+	) {
+
+	std::ofstream file;
+	file.open(log_file_name, std::ios_base::app);
+
+	// runs a point
+	auto run_point = [&](const std::string &mode, Executor &ex) -> Summary {
+		std::function<void()> solve = make_solver(mode, M, N, mean_cost,
+			barrier, C, B, ex);
+		for (uint64_t w=0; w<bench.warmup; ++w)
+			solve();
+		std::vector<double> times(bench.reps);
+		for (double &time : times) {
+			TIMERSTART(bench_run);
+			solve();
+			TIMERSTOP(bench_run, time);
+		}
+		return Summary(times);
+	};
+
+	// logs a point
+	auto log_point = [&](const std::string &mode, Executor &ex,
+		const Summary &summary) -> void {
+		double speedup = (sequential_time > 0) ?
+			sequential_time/summary.median : -1;
+		double efficiency = (speedup > 0) ? speedup/ex.size() : -1;
+		std::printf("%-10s T=%-3u median %fs p10 %fs p90 %fs stddev %fs "
+			"speedup %.2f efficiency %.2f\n", mode.c_str(), ex.size(),
+			summary.median, summary.p10, summary.p90, summary.stddev, speedup,
+			efficiency);
+
+		// (algorithm, N, T, affinity, barrier, warm-up runs, runs, median,
+		// p10, p90, mean, stddev, sequential time, speedup, efficiency,
+		// costs)
+		file << mode << "," << N << "," << ex.size() << ","
+			<< (affinity.find_first_of("0123456789") == 0 ? "list" : affinity)
+			<< "," << barrier << "," << bench.warmup << "," << bench.reps << ","
+			<< summary.median << "," << summary.p10 << "," << summary.p90
+			<< "," << summary.mean << "," << summary.stddev << ","
+			<< sequential_time << "," << speedup << "," << efficiency << ","
+			<< costs << "\n";
+	};
+
+	if (sequential_time < 0 || std::find(bench.modes.begin(),
+		bench.modes.end(), "sequential") != bench.modes.end()) {
+		Executor ex(1, pool.backend, pool.idle, {}, pool.stats);
+		Summary summary = run_point("sequential", ex);
+		sequential_time = summary.median;
+		log_point("sequential", ex, summary);
+	}
+
+	for (const int &T : bench.threads) {
+		Executor ex(T, pool.backend, pool.idle, thread_cpus(affinity, T),
+			pool.stats);
+		for (const std::string &mode : bench.modes)
+			if (mode != "sequential")
+				log_point(mode, ex, run_point(mode, ex));
+	}
+	file.close();
+}
+
+// statistics of the pools (over all the pool-based algorithms, merged
+// over the pools of the executor, see Executor::stats) as CSV
+// fields: tasks of each thread, queue high-water mark, mutex and sleep
+// time, median and 99th percentile of the enqueue-to-start latency and
+// latency histogram (lists separated by ';')
+std::string format_stats(const ThreadPool::Stats &stats) {
+	std::ostringstream fields;
+	for (uint64_t id=0; id<stats.tasks.size(); ++id)
+		fields << (id ? ";" : "") << stats.tasks[id];
+	fields << "," << stats.queue_high_water << "," << stats.mutex_time << ","
+		<< stats.sleep_time << "," << stats.latency_percentile(0.5) << ","
+		<< stats.latency_percentile(0.99) << ",";
+	for (uint64_t b=0; b<stats.latency.size(); ++b)
+		fields << (b ? ";" : "") << stats.latency[b];
+	return fields.str();
+}
+
+// with tracing enabled, writes the trace and prints the time spent by
+// each thread computing, on barriers and waiting for tasks
+void trace_report() {
+	if (TRACE) {
+		Tracer::instance().dump(DEFAULT_TRACE_FILE);
+		Tracer::instance().summary();
+		std::printf("Trace written to %s\n", DEFAULT_TRACE_FILE);
+	}
+}
+
 void print_usage() {
 	std::printf("usage: wavefront [options]\n"
 				"     -h               prints this message\n"
 				"     -N size          size of the square matrix [default=%d]\n"
 				"     -T num_threads   number of threads [default=%d]\n"
-				"     -m min           min waiting time in us [default=%d]\n"
-				"     -M max           max waiting time in us [default=%d]\n"
-				"     -l file_name     log file name [default=%s]\n"
+				"     -m min           min waiting time in units [default=%d]\n"
+				"     -M max           max waiting time in units [default=%d]\n"
+				"     -g unit          unit of the waiting times in ns, the waits\n"
+				"                      are accurate down to about 100 ns\n"
+				"                      [default=%d, microseconds]\n"
+				"     -d distribution  distribution of the waiting times in\n"
+				"                      [min, max]: uniform, exponential (mean\n"
+				"                      (max-min)/4 above min), band (hot bands\n"
+				"                      near the main diagonal, decaying as\n"
+				"                      1/(k+1) on the k-th one), linear (growing\n"
+				"                      with k) or bimodal (90%% in the lowest\n"
+				"                      tenth, 10%% in the highest) [default=%s]\n"
+				"     -F cost_file     reads the waiting times (in ns) from a cost\n"
+				"                      file (see costs.hpp), mapped in memory,\n"
+				"                      instead of drawing them; N is the one of\n"
+				"                      the file\n"
+				"     -O cost_file     writes the waiting times (in ns) to a cost\n"
+				"                      file\n"
+				"     -l file_name     log file name [default=%s,\n"
+				"                      %s with the dot workload]\n"
+				"     -D file_name     log file of all the times and statistics\n"
+				"                      of the algorithms, with a header line\n"
+				"                      (busy workload) [default=%s]\n"
+				"     -q queue         task queue of the pool-based algorithms,\n"
+				"                      central, stealing, priority or ring (the\n"
+				"                      critical-path dataflow algorithm always\n"
+				"                      uses priority) [default=%s]\n"
+				"     -S spins         polls with a pause of an idle pool\n"
+				"                      thread before yielding [default=%d]\n"
+				"     -Y yields        polls with a yield of an idle pool\n"
+				"                      thread before sleeping [default=%d]\n"
+				"     -a affinity      placement of the threads: none, compact,\n"
+				"                      scatter or a list of cpus as 0,2,4-7\n"
+				"                      [default=%s]\n"
+				"     -b barrier       barrier of the static, static balanced and\n"
+				"                      guided algorithms: std, central, tree or\n"
+				"                      dissemination [default=%s]\n"
+				"     -w workload      computation of the elements: busy (waiting\n"
+				"                      for a random time in [min, max]) or dot\n"
+				"                      (cube root of a dot product, executes the\n"
+				"                      sequential, static and dynamic algorithms\n"
+				"                      and checks their results) [default=%s]\n"
+				"     -r reps          runs of each parallel algorithm on the same\n"
+				"                      threads, the first one and the mean of the\n"
+				"                      others are logged separately [default=%d]\n"
+				"     -I instances     matrices (of the same size) solved by the\n"
+				"                      batch algorithm, one after the other and\n"
+				"                      W at a time, 0 to skip both [default=%d]\n"
+				"     -W window        matrices of the batch in flight [default=%d]\n"
+				"     -c chunk_size    minimum chunk size of the guided\n"
+				"                      algorithm [default=%d]\n"
+				"     -B tile_size     tile size of the tiled algorithm,\n"
+				"                      0 to choose it from the costs [default=%d]\n"
+				"     -p               whether to collect the statistics of the pools\n"
+				"                      and log them [not collected by default]\n"
 				"     -s               whether to execute the sequential\n"
-				"                      algorithm [not executed by default]\n",
-				DEFAULT_N, DEFAULT_T, DEFAULT_m, DEFAULT_M, DEFAULT_LOG_FILE);
+				"                      algorithm, as sequential in -A [not\n"
+				"                      executed by default]\n"
+				"     -L thread_list   benchmark mode (busy workload): runs the\n"
+				"                      algorithms of -A with each number of\n"
+				"                      threads of the list (as 1,2,4-8) in this\n"
+				"                      process and logs the statistics of the\n"
+				"                      runs, to %s\n"
+				"                      by default; the speedup is relative to\n"
+				"                      the sequential algorithm if timed (with\n"
+				"                      -s or in -A), else to the sum of the\n"
+				"                      costs [not in benchmark mode by default]\n"
+				"     -A algorithms    algorithms to execute, a list of\n"
+				"                      sequential, dynamic, static, balanced,\n"
+				"                      guided, doacross, dataflow, priority,\n"
+				"                      coroutine and tiled [default=dynamic,static,\n"
+				"                      all but sequential in benchmark mode]\n"
+				"     -u warmup        untimed runs of each point of the\n"
+				"                      benchmark mode [default=%d]\n"
+				"     -R reps          timed runs of each point of the\n"
+				"                      benchmark mode [default=%d]\n",
+				DEFAULT_N, DEFAULT_T, DEFAULT_m, DEFAULT_M, DEFAULT_UNIT,
+				DEFAULT_DISTRIBUTION,
+				DEFAULT_LOG_FILE,
+				DEFAULT_DOT_LOG_FILE, DEFAULT_DETAIL_LOG_FILE, DEFAULT_QUEUE,
+				DEFAULT_SPINS, DEFAULT_YIELDS,
+				DEFAULT_AFFINITY, DEFAULT_BARRIER, DEFAULT_WORKLOAD, DEFAULT_REPS,
+				DEFAULT_INSTANCES, DEFAULT_WINDOW, DEFAULT_C, DEFAULT_B,
+				DEFAULT_BENCH_LOG_FILE, DEFAULT_WARMUP, DEFAULT_BENCH_REPS);
 }
 
 int main(int argc, char *argv[]) {
@@ -147,10 +1117,33 @@ int main(int argc, char *argv[]) {
 	uint64_t N                = DEFAULT_N;
 	uint32_t T                = DEFAULT_T;
 	bool seq_exec             = false;
-	std::string log_file_name = DEFAULT_LOG_FILE;
+	std::string log_file_name = "";
+	std::string detail_log_file_name = DEFAULT_DETAIL_LOG_FILE;
+	std::string queue         = DEFAULT_QUEUE;
+	std::string barrier       = DEFAULT_BARRIER;
+	std::string workload      = DEFAULT_WORKLOAD;
+	uint64_t reps             = DEFAULT_REPS;
+	uint64_t instances        = DEFAULT_INSTANCES;
+	uint64_t W                = DEFAULT_WINDOW;
+	uint64_t C                = DEFAULT_C;
+	uint64_t B                = DEFAULT_B;
+	std::string affinity      = DEFAULT_AFFINITY;
+	PoolConfig pool;
+	pool.idle.spins           = DEFAULT_SPINS;
+	pool.idle.yields          = DEFAULT_YIELDS;
+	BenchConfig bench;
+	std::string thread_list   = "";
+	std::string modes         = "";
+	std::vector<std::string> selected;
+	std::string costs         = DEFAULT_DISTRIBUTION;
+	std::string cost_file     = "";
+	std::string output_cost_file = "";
+	uint64_t unit             = DEFAULT_UNIT;
+	CostDistribution distribution;
+	std::unique_ptr<MappedCosts> mapped_costs;
 
 	int opt;
-	while ((opt = getopt(argc, argv, "hN:T:m:M:s:l:")) != -1) {
+	while ((opt = getopt(argc, argv, "hN:T:m:M:spl:D:q:S:Y:a:b:w:r:I:W:c:B:L:A:u:R:d:F:O:g:")) != -1) {
 		switch (opt) {
 			case 'h':
 				print_usage();
@@ -170,15 +1163,98 @@ int main(int argc, char *argv[]) {
 			case 's':
 				seq_exec = true;
 				break;
+			case 'p':
+				pool.stats = true;
+				break;
 			case 'l':
 				log_file_name = optarg;
 				break;
+			case 'D':
+				detail_log_file_name = optarg;
+				break;
+			case 'q':
+				queue = optarg;
+				break;
+			case 'S':
+				pool.idle.spins = atoi(optarg);
+				break;
+			case 'Y':
+				pool.idle.yields = atoi(optarg);
+				break;
+			case 'a':
+				affinity = optarg;
+				break;
+			case 'b':
+				barrier = optarg;
+				break;
+			case 'w':
+				workload = optarg;
+				break;
+			case 'r':
+				reps = std::max(atoi(optarg), 1);
+				break;
+			case 'I':
+				instances = std::max(atoi(optarg), 0);
+				break;
+			case 'W':
+				W = std::max(atoi(optarg), 1);
+				break;
+			case 'c':
+				C = std::max(atoi(optarg), 1);
+				break;
+			case 'B':
+				B = atoi(optarg);
+				break;
+			case 'L':
+				thread_list = optarg;
+				break;
+			case 'A':
+				modes = optarg;
+				break;
+			case 'u':
+				bench.warmup = std::max(atoi(optarg), 0);
+				break;
+			case 'R':
+				bench.reps = std::max(atoi(optarg), 1);
+				break;
+			case 'd':
+				costs = optarg;
+				break;
+			case 'F':
+				cost_file = optarg;
+				break;
+			case 'O':
+				output_cost_file = optarg;
+				break;
+			case 'g':
+				unit = std::max(atoi(optarg), 1);
+				break;
 			case '?':
 				if (optopt == 'N' ||
 					optopt == 'T' ||
 					optopt == 'm' ||
 					optopt == 'M' ||
-					optopt == 'l')
+					optopt == 'l' ||
+					optopt == 'D' ||
+					optopt == 'q' ||
+					optopt == 'S' ||
+					optopt == 'Y' ||
+					optopt == 'a' ||
+					optopt == 'b' ||
+					optopt == 'w' ||
+					optopt == 'r' ||
+					optopt == 'I' ||
+					optopt == 'W' ||
+					optopt == 'c' ||
+					optopt == 'B' ||
+					optopt == 'L' ||
+					optopt == 'A' ||
+					optopt == 'u' ||
+					optopt == 'R' ||
+					optopt == 'd' ||
+					optopt == 'F' ||
+					optopt == 'O' ||
+					optopt == 'g')
 					std::cerr << "Option -" << static_cast<char>(optopt)
 						<< " requires an argument.\n";
 				else if (isprint(optopt))
@@ -194,53 +1270,236 @@ int main(int argc, char *argv[]) {
 		}
 	}
 
-	// allocate the matrix
-	std::vector<int> M(N*N, -1);
+	if (queue == "central")
+		pool.backend = ThreadPool::Backend::CENTRAL;
+	else if (queue == "stealing")
+		pool.backend = ThreadPool::Backend::WORK_STEALING;
+	else if (queue == "priority")
+		pool.backend = ThreadPool::Backend::PRIORITY;
+	else if (queue == "ring")
+		pool.backend = ThreadPool::Backend::RING;
+	else {
+		std::cerr << "Unknown task queue `" << queue << "`.\n";
+		print_usage();
+		return 1;
+	}
 
-	uint64_t expected_seq_totaltime=0;
-	// init function
-	auto init=[&]() {
-		for(uint64_t k=0; k<N; ++k) {
-			for(uint64_t i=0; i<(N-k); ++i) {
-				int t = random(min,max);
-				M[i*N+(i+k)] = t;
-				expected_seq_totaltime +=t;
-			}
+	if (workload != "busy" && workload != "dot") {
+		std::cerr << "Unknown workload `" << workload << "`.\n";
+		print_usage();
+		return 1;
+	}
+	if (log_file_name.empty())
+		log_file_name = (workload == "dot") ? DEFAULT_DOT_LOG_FILE :
+			!thread_list.empty() ? DEFAULT_BENCH_LOG_FILE : DEFAULT_LOG_FILE;
+
+	try {
+		pool.cpus = thread_cpus(affinity, T);
+		with_barrier(barrier, 1, {}, [](auto &) {});
+		distribution = cost_distribution(costs);
+		if (uint64_t(std::max({min, max, 0}))*unit > INT_MAX)
+			throw std::invalid_argument("waiting times too long for the unit");
+		if (!cost_file.empty()) {
+			mapped_costs = std::make_unique<MappedCosts>(cost_file);
+			N = mapped_costs->order();
 		}
+		if (modes.empty())
+			modes = thread_list.empty() ? DEFAULT_MAIN_ALGORITHMS :
+				DEFAULT_ALGORITHMS;
+		selected = split_list(modes);
+		for (const std::string &mode : selected)
+			if (std::find(algorithms.begin(), algorithms.end(), mode) ==
+				algorithms.end())
+				throw std::invalid_argument("unknown algorithm `" + mode + "`");
+		if (seq_exec && std::find(selected.begin(), selected.end(),
+			"sequential") == selected.end())
+			selected.push_back("sequential");
+		if (!thread_list.empty()) {
+			bench.threads = parse_cpu_list(thread_list);
+			bench.modes = selected;
+			for (const int &threads : bench.threads)
+				if (threads < 1)
+					throw std::invalid_argument("invalid number of threads `" + thread_list + "`");
+		}
+	}
+	catch (const std::exception &e) {
+		std::cerr << e.what() << ".\n";
+		print_usage();
+		return 1;
+	}
+
+	if (TRACE) trace_thread_name("main");
+
+	// calibrate the waits before anything is timed
+	DEBUG_PRINT("%.3f time stamp counter ticks per ns\n",
+		tsc_calibration().ticks_per_ns)
+
+	// the threads are created (and pinned) once for all the runs
+	double startup_time;
+	TIMERSTART(executor_startup);
+	std::optional<Executor> executor;
+	executor.emplace(T, pool.backend, pool.idle, pool.cpus, pool.stats);
+	Executor &ex = *executor;
+	ThreadPool &TP = ex.pool();
+	TIMERSTOP(executor_startup, startup_time);
+
+	if (workload == "dot") {
+		int status = dot_main(N, T, barrier, reps, ex, log_file_name);
+		trace_report();
+		return status;
+	}
+
+	// allocate the upper triangle of the matrix and set the costs, read
+	// from the cost file or drawn from the distribution (in parallel)
+	Matrix M(N);
+	uint64_t expected_seq_totaltime;
+	if (mapped_costs)
+		expected_seq_totaltime = fill_costs(M, N, T, *mapped_costs, ex);
+	else
+		expected_seq_totaltime = fill_costs(M, N, T,
+			Scaled(CostGenerator(distribution, min, max, N, SEED), unit), ex);
+	try {
+		if (!output_cost_file.empty())
+			write_costs(output_cost_file, M);
+	}
+	catch (const std::exception &e) {
+		std::cerr << e.what() << ".\n";
+		return 1;
+	}
+
+	// benchmark mode, on an executor per thread count (the threads of ex,
+	// which only filled the matrix, are stopped first)
+	if (!bench.threads.empty()) {
+		executor.reset();
+		bench_main(M, N, expected_seq_totaltime/(N*(N+1)/2.0),
+			seq_exec ? -1 : expected_seq_totaltime/1e9, bench, pool, affinity,
+			barrier, C, B, mapped_costs ? "file" : costs, log_file_name);
+		trace_report();
+		return 0;
+	}
+
+	// the algorithms of -A, in the order of algorithms: the sequential one
+	// is run once, each parallel one reps times, the first run (cold) and
+	// the mean of the others (steady state) are timed separately (-1 for
+	// the algorithms not run); what an algorithm computes from the costs
+	// is built before starting the timer, as the costs are known in advance
+	const double mean_cost = expected_seq_totaltime/(N*(N+1)/2.0);
+	if (B == 0)
+		B = auto_tile_size(mean_cost, N, T);
+	auto runs = [&](const std::string &mode) -> bool {
+		return std::find(selected.begin(), selected.end(), mode) !=
+			selected.end();
 	};
-	
-	init();
+	std::map<std::string, std::pair<double, double>> times;
+	for (const std::string &mode : algorithms) {
+		times[mode] = {-1, -1};
+		if (!runs(mode))
+			continue;
+		// the critical paths take 8 bytes per element
+		if (mode == "priority" && !fits_in_memory(N*(N+1)/2*sizeof(uint64_t))) {
+			std::printf("Not enough free memory for the critical paths, the "
+				"critical-path dataflow algorithm is skipped\n");
+			continue;
+		}
+		if (DEBUG) std::printf("------ %s execution ------\n", mode.c_str());
+		std::function<void()> solve = make_solver(mode, M, N, mean_cost,
+			barrier, C, B, ex);
+		measure(solve, (mode == "sequential") ? 1 : reps, times[mode].first,
+			times[mode].second);
+	}
 
-	// sequential execution
-	double actual_seq_totaltime=-1;
-	if (seq_exec) {
-		if (DEBUG) std::printf("------ Sequential execution ------ \n");
-		TIMERSTART(wavefront_sequential);
-		wavefront_sequential(M, N); 
-		TIMERSTOP(wavefront_sequential, actual_seq_totaltime);
+	// imbalance of the static partitions and lower bound of the makespan
+	// (s), logged with the algorithms that use them
+	double static_imbalance=-1, balanced_imbalance=-1, critical_path=-1;
+	if (runs("balanced")) {
+		Partition partition = balanced_partition(M, N, T);
+		static_imbalance = imbalance(M, N, T,
+			[&](uint64_t k, uint64_t i) -> uint32_t {
+				return ((i+1)*T-1)/(N-k);
+			});
+		balanced_imbalance = imbalance(M, N, T,
+			[&](uint64_t k, uint64_t i) -> uint32_t {
+				return partition.owner(k,i);
+			});
+	}
+	if (times["priority"].first >= 0) {
+		PackedMatrix<uint64_t> paths = critical_paths(M, N);
+		critical_path = *std::max_element(paths.diagonal(0),
+			paths.diagonal(0)+N)/1e9;
 	}
-	
-	// parallel dynamic execution
-	double par_dynamic_totaltime;
-	if (DEBUG) std::printf("------ Parallel dynamic execution ------\n");
-	TIMERSTART(wavefront_parallel_dynamic);
-	wavefront_parallel_dynamic(M, N, T); 
-	TIMERSTOP(wavefront_parallel_dynamic, par_dynamic_totaltime);
 
-	// parallel static execution
-	double par_static_totaltime;
-	if (DEBUG) std::printf("------ Parallel static execution ------\n");
-	TIMERSTART(wavefront_parallel_static);
-	wavefront_parallel_static(M, N, T); 
-	TIMERSTOP(wavefront_parallel_static, par_static_totaltime);
+	// batch of independent matrices, solved by the batch algorithm one
+	// after the other (one in flight) and interleaved (W in flight), with
+	// the same T chunks per diagonal (the costs are drawn from the
+	// distribution, with the streams after the one of M)
+	double par_batch_totaltime=-1, par_batch_sequence_totaltime=-1;
+	if (instances > 0) {
+		std::vector<Matrix> batch;
+		for (uint64_t m=0; m<instances; ++m) {
+			batch.emplace_back(N);
+			fill_costs(batch.back(), N, T,
+				Scaled(CostGenerator(distribution, min, max, N, SEED+m+1), unit),
+				ex);
+		}
+
+		if (DEBUG) std::printf("------ Parallel batch execution (1 in "
+			"flight) ------\n");
+		TIMERSTART(wavefront_parallel_batch_sequence);
+		wavefront_parallel_batch(batch, N, T, 1, TP);
+		TIMERSTOP(wavefront_parallel_batch_sequence,
+			par_batch_sequence_totaltime);
+
+		if (DEBUG) std::printf("------ Parallel batch execution ------\n");
+		TIMERSTART(wavefront_parallel_batch);
+		wavefront_parallel_batch(batch, N, T, W, TP);
+		TIMERSTOP(wavefront_parallel_batch, par_batch_totaltime);
+
+		std::printf("Batch of %lu matrices: %.2f solves/s one after the other, "
+			"%.2f solves/s interleaved (%lu in flight)\n", instances,
+			instances/par_batch_sequence_totaltime,
+			instances/par_batch_totaltime, W);
+	}
 
 	// write the execution times to a file
 	std::ofstream file;
 	file.open(log_file_name, std::ios_base::app);
 	file << N << "," << T << "," << min << "," << max << ","
-		<< expected_seq_totaltime/1000000 << "," << actual_seq_totaltime << ","
-		<< par_dynamic_totaltime << "," << par_static_totaltime << "\n";
+		<< expected_seq_totaltime/1000000000 << ","
+		<< times["sequential"].first << "," << times["dynamic"].first << ","
+		<< times["static"].first << "\n";
+	file.close();
+
+	// write all the times and statistics to the detail log, with a header
+	// line if it is a new file
+	bool header = std::ifstream(detail_log_file_name).peek() ==
+		std::ifstream::traits_type::eof();
+	file.open(detail_log_file_name, std::ios_base::app);
+	if (header) {
+		file << "N,T,min,max,costs,unit,queue,spins,yields,affinity,barrier,"
+			"reps,startup";
+		for (const std::string &mode : algorithms)
+			file << "," << mode << "," << mode << "_steady";
+		file << ",C,B,static_imbalance,balanced_imbalance,critical_path,"
+			"tasks,queue_high_water,mutex_time,sleep_time,latency_p50,"
+			"latency_p99,latency,instances,W,batch_sequence,batch,"
+			"batch_sequence_rate,batch_rate\n";
+	}
+	file << N << "," << T << "," << min << "," << max << ","
+		<< (mapped_costs ? "file" : costs) << "," << unit << "," << queue
+		<< "," << pool.idle.spins << "," << pool.idle.yields << ","
+		<< (affinity.find_first_of("0123456789") == 0 ? "list" : affinity)
+		<< "," << barrier << "," << reps << "," << startup_time;
+	for (const std::string &mode : algorithms)
+		file << "," << times[mode].first << "," << times[mode].second;
+	file << "," << C << "," << B << "," << static_imbalance << ","
+		<< balanced_imbalance << "," << critical_path << ","
+		<< format_stats(ex.stats()) << "," << instances << "," << W << ","
+		<< par_batch_sequence_totaltime << "," << par_batch_totaltime << ","
+		<< ((instances > 0) ? instances/par_batch_sequence_totaltime : -1) << ","
+		<< ((instances > 0) ? instances/par_batch_totaltime : -1) << "\n";
 	file.close();
 
+	trace_report();
+
 	return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,337 @@
+#include <iostream>
+#include <unistd.h>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <algorithm>
+#include <spin.hpp>
+#include <costs.hpp>
+#include "mpi.h"
+
+#define DEFAULT_LOG_FILE "wavefront_mpi_log.csv" // default log file name
+#define DEFAULT_N 512 // default size of the square matrix (NxN)
+#define DEFAULT_m 0 // default minimum time (in units)
+#define DEFAULT_M 1000 // default maximum time (in units)
+#define DEFAULT_UNIT 1000 // default unit of the times (in ns, 1000 for microseconds)
+#define DEFAULT_DISTRIBUTION "uniform" // default distribution of the costs
+#define DEFAULT_ROWS 0 // default rows of a block (0 for one block per process)
+#define DEFAULT_COLS 32 // default columns of a tile (sent in a message)
+#define SEED 117 // stream of the random costs, as in wavefront
+
+// Distributed wavefront on the upper triangle of an NxN matrix, where the
+// element (i,j) depends on (i,j-1) and (i+1,j). The rows are split into
+// blocks of R rows, dealt round-robin to the processes (block-cyclic, a
+// block per process if R is N/P). The columns are split into tiles of C
+// columns: a process computes the tiles from left to right, and in each
+// tile its blocks from the bottom up. The top row of a block is the
+// boundary of the block above: the part in a tile is sent with a
+// non-blocking send as soon as the tile of the block is computed, and the
+// receives of all the boundaries are posted at the start, so that the
+// processes form a pipeline and never synchronize on a whole diagonal.
+//
+// Computing an element busy-waits for its cost, drawn from the
+// distribution with the same counter-based streams as wavefront (each
+// process draws the costs of its elements, no costs are sent), and sets
+// its value to V(i,j-1)*31 + V(i+1,j) (V(i,i) = i+1, modulo 2^64), so that
+// the top right element and the sum of the elements, checked against a
+// sequential computation, depend on all the elements and on their order.
+
+#define TIMERSTART(label)\
+	double a##label = MPI_Wtime();
+
+#define TIMERSTOP(label, time_elapsed)\
+	time_elapsed = MPI_Wtime()-a##label;
+
+// value of (i,j) from the one on its left and the one below
+inline uint64_t combine(const uint64_t &left, const uint64_t &below) {
+	return left*31 + below;
+}
+
+// the rows [first, last) of the matrix, from column first to N-1, and the
+// boundary below them (row last, from column last), received from the
+// process computing the next block
+struct Block {
+	uint64_t id;
+	uint64_t first;
+	uint64_t last;
+	uint64_t width; // N-first
+	std::vector<uint64_t> values;
+	std::vector<uint64_t> below;
+	std::vector<MPI_Request> receives; // of the boundary, by tile
+
+	uint64_t& operator()(const uint64_t &i, const uint64_t &j) {
+		return values[(i-first)*width + (j-first)];
+	}
+};
+
+// columns [begin, end) of the tile t of the rows starting at row (the
+// columns of a row start at its index), empty if the tile is on the left
+void tile_columns(const uint64_t &t, const uint64_t &C, const uint64_t &N,
+	const uint64_t &row, uint64_t &begin, uint64_t &end) {
+	end = std::min((t+1)*C, N);
+	begin = std::min(std::max(t*C, row), end);
+}
+
+// sequential computation of the values, without waiting: the value of the
+// top right element and the sum of all the elements
+void wavefront_sequential(const uint64_t &N, uint64_t &top_right,
+	uint64_t &sum) {
+	std::vector<uint64_t> row(N); // the row below, then the current one
+	sum = 0;
+	for (uint64_t i=N; i-- > 0;) { // from the last row
+		row[i] = i+1;
+		sum += row[i];
+		for (uint64_t j=i+1; j<N; ++j) {
+			row[j] = combine(row[j-1], row[j]);
+			sum += row[j];
+		}
+	}
+	top_right = row[N-1];
+}
+
+// parallel computation (see above), returns the sum of the elements of the
+// blocks of this process and sets the seconds spent waiting for boundaries
+uint64_t wavefront_mpi(
+	MPI_Comm comm,
+	const uint64_t &N,
+	const uint64_t &R,
+	const uint64_t &C,
+	const CostGenerator &cost,
+	const uint64_t &unit,
+	std::vector<Block> &blocks,
+	double &wait_time
+	) {
+
+	int numP, rank;
+	MPI_Comm_size(comm, &numP);
+	MPI_Comm_rank(comm, &rank);
+	const uint64_t nblocks = (N+R-1)/R;
+	const uint64_t ntiles = (N+C-1)/C;
+
+	// the blocks of this process, from the top, with the receives of the
+	// boundaries posted in advance; the messages between two processes
+	// are told apart by the tag, the index of the receiving block among
+	// the ones of its process, and are matched in order within a tag
+	blocks.clear();
+	for (uint64_t b=rank; b<nblocks; b+=numP) {
+		Block block;
+		block.id = b;
+		block.first = b*R;
+		block.last = std::min((b+1)*R, N);
+		block.width = N-block.first;
+		block.values.resize((block.last-block.first)*block.width);
+		block.below.resize(N-block.last);
+		blocks.push_back(std::move(block));
+	}
+	for (Block &block : blocks) {
+		if (block.last == N)
+			continue; // the last block has nothing below
+		for (uint64_t t=0; t<ntiles; ++t) {
+			uint64_t begin, end;
+			tile_columns(t, C, N, block.last, begin, end);
+			block.receives.push_back(MPI_REQUEST_NULL);
+			if (begin < end)
+				MPI_Irecv(&block.below[begin-block.last], end-begin,
+					MPI_UINT64_T, (block.id+1) % numP, block.id/numP, comm,
+					&block.receives.back());
+		}
+	}
+
+	std::vector<MPI_Request> sends;
+	wait_time = 0;
+	uint64_t sum = 0;
+	for (uint64_t t=0; t<ntiles; ++t) { // for each tile
+		for (auto block=blocks.rbegin(); block!=blocks.rend(); ++block) {
+			uint64_t begin, end;
+			tile_columns(t, C, N, block->first, begin, end);
+			if (begin == end)
+				continue;
+
+			// the boundary of the tile, if it reaches below the block
+			if (block->last < N && end > block->last) {
+				double waited;
+				TIMERSTART(boundary);
+				MPI_Wait(&block->receives[t], MPI_STATUS_IGNORE);
+				TIMERSTOP(boundary, waited);
+				wait_time += waited;
+			}
+
+			for (uint64_t i=block->last; i-- > block->first;) { // bottom up
+				for (uint64_t j=std::max(begin, i); j<end; ++j) {
+					spin_for(std::chrono::nanoseconds(cost(j-i, i)*unit));
+					uint64_t value = i+1;
+					if (j > i) {
+						uint64_t below = (i+1 < block->last) ? (*block)(i+1,j) :
+							block->below[j-block->last];
+						value = combine((*block)(i,j-1), below);
+					}
+					(*block)(i,j) = value;
+					sum += value;
+				}
+			}
+
+			// the top row of the tile is the boundary of the block above
+			if (block->id > 0) {
+				sends.push_back(MPI_REQUEST_NULL);
+				MPI_Isend(&(*block)(block->first, begin), end-begin,
+					MPI_UINT64_T, (block->id-1) % numP, (block->id-1)/numP,
+					comm, &sends.back());
+			}
+		}
+	}
+	MPI_Waitall(sends.size(), sends.data(), MPI_STATUSES_IGNORE);
+	return sum;
+}
+
+void print_usage() {
+	std::printf("usage: mpirun -n P wavefront_mpi [options]\n"
+				"     -h               prints this message\n"
+				"     -N size          size of the square matrix [default=%d]\n"
+				"     -m min           min waiting time in units [default=%d]\n"
+				"     -M max           max waiting time in units [default=%d]\n"
+				"     -g unit          unit of the waiting times in ns\n"
+				"                      [default=%d, microseconds]\n"
+				"     -d distribution  distribution of the waiting times, as in\n"
+				"                      wavefront: uniform, exponential, band,\n"
+				"                      linear or bimodal [default=%s]\n"
+				"     -r rows          rows of a block, the blocks are dealt\n"
+				"                      round-robin to the processes, 0 for a\n"
+				"                      block per process [default=%d]\n"
+				"     -c columns       columns of a tile, i.e. of the part of a\n"
+				"                      boundary sent in a message [default=%d]\n"
+				"     -l file_name     log file name [default=%s]\n",
+				DEFAULT_N, DEFAULT_m, DEFAULT_M, DEFAULT_UNIT,
+				DEFAULT_DISTRIBUTION, DEFAULT_ROWS, DEFAULT_COLS,
+				DEFAULT_LOG_FILE);
+}
+
+int main(int argc, char *argv[]) {
+	MPI_Init(&argc, &argv);
+
+	int numP, rank;
+	MPI_Comm_size(MPI_COMM_WORLD, &numP);
+	MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+	int min                   = DEFAULT_m;
+	int max                   = DEFAULT_M;
+	uint64_t N                = DEFAULT_N;
+	uint64_t unit             = DEFAULT_UNIT;
+	uint64_t R                = DEFAULT_ROWS;
+	uint64_t C                = DEFAULT_COLS;
+	std::string costs         = DEFAULT_DISTRIBUTION;
+	std::string log_file_name = DEFAULT_LOG_FILE;
+
+	// all the processes parse the same arguments, only the first one prints
+	int opt;
+	int status = -1;
+	opterr = (rank == 0);
+	while ((opt = getopt(argc, argv, "hN:m:M:g:d:r:c:l:")) != -1) {
+		switch (opt) {
+			case 'h':
+				status = 0;
+				break;
+			case 'N':
+				N = std::max(atoi(optarg), 1);
+				break;
+			case 'm':
+				min = atoi(optarg);
+				break;
+			case 'M':
+				max = atoi(optarg);
+				break;
+			case 'g':
+				unit = std::max(atoi(optarg), 1);
+				break;
+			case 'd':
+				costs = optarg;
+				break;
+			case 'r':
+				R = std::max(atoi(optarg), 0);
+				break;
+			case 'c':
+				C = std::max(atoi(optarg), 1);
+				break;
+			case 'l':
+				log_file_name = optarg;
+				break;
+			default:
+				status = 1;
+				break;
+		}
+	}
+
+	CostDistribution distribution = CostDistribution::UNIFORM;
+	if (status < 0) {
+		try {
+			distribution = cost_distribution(costs);
+		}
+		catch (const std::exception &e) {
+			if (rank == 0)
+				std::cerr << e.what() << ".\n";
+			status = 1;
+		}
+	}
+	if (status >= 0) {
+		if (rank == 0)
+			print_usage();
+		MPI_Finalize();
+		return status;
+	}
+	if (R == 0)
+		R = (N+numP-1)/numP;
+
+	// calibrate the waits before anything is timed
+	tsc_calibration();
+	CostGenerator cost(distribution, min, max, N, SEED);
+
+	std::vector<Block> blocks;
+	double wait_time, time;
+	MPI_Barrier(MPI_COMM_WORLD);
+	TIMERSTART(wavefront_mpi);
+	uint64_t local_sum = wavefront_mpi(MPI_COMM_WORLD, N, R, C, cost, unit,
+		blocks, wait_time);
+	MPI_Barrier(MPI_COMM_WORLD);
+	TIMERSTOP(wavefront_mpi, time);
+
+	// sum of the elements and of the costs, longest wait for boundaries
+	uint64_t local_cost = 0;
+	for (const Block &block : blocks)
+		for (uint64_t i=block.first; i<block.last; ++i)
+			for (uint64_t j=i; j<N; ++j)
+				local_cost += cost(j-i, i)*unit;
+	uint64_t sum = 0, total_cost = 0;
+	double max_wait_time = 0;
+	MPI_Reduce(&local_sum, &sum, 1, MPI_UINT64_T, MPI_SUM, 0, MPI_COMM_WORLD);
+	MPI_Reduce(&local_cost, &total_cost, 1, MPI_UINT64_T, MPI_SUM, 0,
+		MPI_COMM_WORLD);
+	MPI_Reduce(&wait_time, &max_wait_time, 1, MPI_DOUBLE, MPI_MAX, 0,
+		MPI_COMM_WORLD);
+
+	bool ok = true;
+	if (rank == 0) {
+		// the first block, with the top right element, is on this process
+		uint64_t expected_top_right, expected_sum;
+		wavefront_sequential(N, expected_top_right, expected_sum);
+		ok = (blocks[0](0, N-1) == expected_top_right) && (sum == expected_sum);
+
+		std::printf("N=%lu P=%d rows=%lu columns=%lu: %fs (sum of the costs "
+			"%fs, %fs per process), longest wait for boundaries %fs\n", N, numP,
+			R, C, time, total_cost/1e9, total_cost/1e9/numP, max_wait_time);
+		if (!ok)
+			std::cerr << "The result differs from the sequential one.\n";
+
+		// write the execution time to a file
+		// (N, P, rows, columns, min, max, unit, costs, time, sum of the
+		// costs, longest wait, check)
+		std::ofstream file;
+		file.open(log_file_name, std::ios_base::app);
+		file << N << "," << numP << "," << R << "," << C << "," << min << ","
+			<< max << "," << unit << "," << costs << "," << time << ","
+			<< total_cost/1e9 << "," << max_wait_time << "," << ok << "\n";
+		file.close();
+	}
+
+	MPI_Bcast(&ok, 1, MPI_CXX_BOOL, 0, MPI_COMM_WORLD);
+	MPI_Finalize();
+	return ok ? 0 : 1;
+}